@@ -0,0 +1,42 @@
+#include "Arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+void* Arena::allocate(std::size_t size, std::size_t alignment) {
+    auto fit = [&](const Block& block, std::size_t offset) -> std::size_t {
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.memory.get());
+        std::uintptr_t aligned = (base + offset + alignment - 1) / alignment * alignment;
+        std::size_t start = static_cast<std::size_t>(aligned - base);
+        return start <= block.size && size <= block.size - start ? start : SIZE_MAX;
+    };
+
+    // The current block, then blocks left over from before the last reset, then a new one.
+    for (; current < blocks.size(); ++current, used = 0) {
+        std::size_t start = fit(blocks[current], used);
+        if (start != SIZE_MAX) {
+            used = start + size;
+            return blocks[current].memory.get() + start;
+        }
+    }
+
+    std::size_t block_size = blocks.empty() ? ARENA_FIRST_BLOCK : std::min(blocks.back().size * 2, ARENA_MAX_BLOCK);
+    block_size = std::max(block_size, size + alignment);
+    blocks.push_back(Block{ std::make_unique<unsigned char[]>(block_size), block_size });
+    current = blocks.size() - 1;
+    std::size_t start = fit(blocks[current], 0);
+    used = start + size;
+    return blocks[current].memory.get() + start;
+}
+
+void Arena::reset() {
+    for (Destructor* entry = destructors; entry; entry = entry->next) entry->destroy(entry->object);
+    destructors = nullptr;
+    current = 0;
+    used = 0;
+}
+
+std::size_t Arena::capacity() const {
+    std::size_t total = 0;
+    for (const Block& block : blocks) total += block.size;
+    return total;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+const std::size_t ARENA_FIRST_BLOCK = 64 * 1024;
+const std::size_t ARENA_MAX_BLOCK = 16 * 1024 * 1024;
+
+// --- Arena: monotonic bump allocator, freed all at once ---
+// Allocating moves a pointer forward; there is no way to free a single object. reset()
+// destroys everything created since the last reset and rewinds, but keeps the memory, so
+// an arena that is reset every tick or every level stops allocating once it has grown to
+// its largest use. Each new block is twice as large as the last (up to ARENA_MAX_BLOCK), so
+// even a huge level takes only a handful of allocations.
+class Arena {
+    struct Block {
+        std::unique_ptr<unsigned char[]> memory;
+        std::size_t size;
+    };
+    // Registered for every object whose destructor has to run; lives in the arena itself.
+    struct Destructor {
+        void (*destroy)(void*);
+        void* object;
+        Destructor* next;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t current = 0; // block being filled
+    std::size_t used = 0;    // bytes of it already handed out
+    Destructor* destructors = nullptr;
+
+public:
+    Arena() = default;
+    ~Arena() { reset(); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialized storage for count values, e.g. scratch arrays of doubles.
+    template<typename T>
+    T* allocate_array(std::size_t count, std::size_t alignment = alignof(T)) {
+        static_assert(std::is_trivially_destructible_v<T>, "Arrays are never destroyed");
+        return static_cast<T*>(allocate(count * sizeof(T), alignment));
+    }
+
+    // Constructs a T that lives until the next reset().
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            return new (memory) T(std::forward<Args>(args)...);
+        }
+        else {
+            // Allocated first, so a throwing constructor leaves no dangling registration.
+            Destructor* entry = static_cast<Destructor*>(allocate(sizeof(Destructor), alignof(Destructor)));
+            T* object = new (memory) T(std::forward<Args>(args)...);
+            *entry = Destructor{ [](void* p) { static_cast<T*>(p)->~T(); }, object, destructors };
+            destructors = entry;
+            return object;
+        }
+    }
+
+    // Destroys all created objects, newest first, and makes all memory available again.
+    void reset();
+    // Trades everything created and all memory with the other arena, without touching either.
+    void swap(Arena& other) noexcept {
+        blocks.swap(other.blocks);
+        std::swap(current, other.current);
+        std::swap(used, other.used);
+        std::swap(destructors, other.destructors);
+    }
+
+    std::size_t block_count() const { return blocks.size(); }
+    std::size_t capacity() const;
+};
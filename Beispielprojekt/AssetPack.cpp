@@ -0,0 +1,306 @@
+#include "AssetPack.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+static const std::uint32_t PACK_MAGIC = 0x4b415041; // "APAK"
+static const std::uint32_t PACK_VERSION = 1;
+
+std::uint64_t content_hash(const void* data, std::size_t size, std::uint64_t hash) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+    return hash;
+}
+
+// --- LZ4 block format ---
+// A block is a list of sequences: token (literal count << 4 | match length - 4), literals,
+// 2-byte match offset, with 255-byte continuations for counts of 15 or more. The last
+// sequence has no match, the last match starts at least 12 bytes before the end and the
+// last 5 bytes are always literals.
+
+static const std::size_t LZ4_MIN_MATCH = 4;
+static const std::size_t LZ4_LAST_LITERALS = 5;
+static const std::size_t LZ4_MATCH_START_LIMIT = 12;
+static const std::size_t LZ4_MAX_OFFSET = 65535;
+static const int LZ4_HASH_BITS = 16;
+
+static std::uint32_t load_u32(const unsigned char* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static void put_length(std::vector<unsigned char>& out, std::size_t length) {
+    for (; length >= 255; length -= 255) out.push_back(255);
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+static void put_sequence(std::vector<unsigned char>& out, const unsigned char* literals,
+    std::size_t literal_count, std::size_t match_length, std::size_t offset) {
+    std::size_t match_code = match_length ? match_length - LZ4_MIN_MATCH : 0;
+    out.push_back(static_cast<unsigned char>(std::min<std::size_t>(literal_count, 15) << 4 |
+        std::min<std::size_t>(match_code, 15)));
+    if (literal_count >= 15) put_length(out, literal_count - 15);
+    out.insert(out.end(), literals, literals + literal_count);
+    if (match_length == 0) return;
+    out.push_back(static_cast<unsigned char>(offset));
+    out.push_back(static_cast<unsigned char>(offset >> 8));
+    if (match_code >= 15) put_length(out, match_code - 15);
+}
+
+static std::vector<unsigned char> lz4_compress(const unsigned char* data, std::size_t size) {
+    std::vector<unsigned char> out;
+    out.reserve(size + size / 255 + 16);
+    std::vector<std::uint32_t> table(std::size_t(1) << LZ4_HASH_BITS, 0);
+
+    std::size_t anchor = 0, i = 0, misses = 0;
+    const std::size_t match_end_limit = size - std::min(size, LZ4_LAST_LITERALS);
+    while (i + LZ4_MATCH_START_LIMIT <= size) {
+        std::uint32_t sequence = load_u32(data + i);
+        std::uint32_t& slot = table[(sequence * 2654435761u) >> (32 - LZ4_HASH_BITS)];
+        std::size_t candidate = slot;
+        slot = static_cast<std::uint32_t>(i);
+
+        if (candidate < i && i - candidate <= LZ4_MAX_OFFSET && load_u32(data + candidate) == sequence) {
+            std::size_t length = LZ4_MIN_MATCH;
+            while (i + length < match_end_limit && data[candidate + length] == data[i + length]) ++length;
+            put_sequence(out, data + anchor, i - anchor, length, i - candidate);
+            i += length;
+            anchor = i;
+            misses = 0;
+        }
+        else {
+            // Skip ahead faster the longer nothing matches, so incompressible data is cheap.
+            i += 1 + (misses++ >> 6);
+        }
+    }
+    put_sequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+static bool read_length(const unsigned char* in, std::size_t in_size, std::size_t& ip, std::size_t& length) {
+    unsigned char byte;
+    do {
+        if (ip >= in_size) return false;
+        byte = in[ip++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Returns false if the block is corrupt or does not decompress to exactly out_size bytes.
+static bool lz4_decompress(const unsigned char* in, std::size_t in_size,
+    unsigned char* out, std::size_t out_size) {
+    std::size_t ip = 0, op = 0;
+    while (ip < in_size) {
+        unsigned token = in[ip++];
+        std::size_t literals = token >> 4;
+        if (literals == 15 && !read_length(in, in_size, ip, literals)) return false;
+        if (literals > in_size - ip || literals > out_size - op) return false;
+        if (literals) std::memcpy(out + op, in + ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == in_size) break;
+
+        if (in_size - ip < 2) return false;
+        std::size_t offset = in[ip] | in[ip + 1] << 8;
+        ip += 2;
+        std::size_t length = token & 15;
+        if (length == 15 && !read_length(in, in_size, ip, length)) return false;
+        length += LZ4_MIN_MATCH;
+        if (offset == 0 || offset > op || length > out_size - op) return false;
+
+        const unsigned char* match = out + op - offset;
+        if (offset >= length) std::memcpy(out + op, match, length);
+        else for (std::size_t k = 0; k < length; ++k) out[op + k] = match[k]; // overlapping
+        op += length;
+    }
+    return op == out_size;
+}
+
+// --- Pack Builder ---
+
+static void write_padding(Gosu::Writer& writer, std::size_t count) {
+    static const unsigned char zeros[PACK_ALIGNMENT] = {};
+    writer.write(zeros, count);
+}
+
+void build_asset_pack(const std::string& filename, const std::vector<std::string>& files) {
+    struct Source {
+        std::string name;
+        PackCodec codec;
+        std::uint64_t size, hash;
+        std::vector<unsigned char> bytes;
+    };
+    std::vector<Source> sources;
+    for (const std::string& path : files) {
+        Source source;
+        source.name = std::filesystem::path(path).filename().string();
+        if (source.name.size() > 0xffff) throw std::invalid_argument("Asset name too long: " + path);
+
+        MappedFile input(path);
+        const unsigned char* data = static_cast<const unsigned char*>(input.data());
+        source.size = input.size();
+        source.hash = content_hash(data, input.size());
+        source.bytes = lz4_compress(data, input.size());
+        source.codec = PACK_LZ4;
+        if (source.bytes.size() >= input.size()) {
+            source.bytes.assign(data, data + input.size());
+            source.codec = PACK_STORED;
+        }
+        sources.push_back(std::move(source));
+    }
+    std::sort(sources.begin(), sources.end(),
+        [](const Source& a, const Source& b) { return a.name < b.name; });
+    for (std::size_t i = 1; i < sources.size(); ++i) {
+        if (sources[i].name == sources[i - 1].name) {
+            throw std::invalid_argument("Two assets are named " + sources[i].name);
+        }
+    }
+
+    auto align = [](std::uint64_t offset) {
+        return (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+    };
+    std::uint64_t offset = 12;
+    for (const Source& source : sources) offset += 2 + source.name.size() + 1 + 4 * 8;
+
+    Gosu::File file(filename, Gosu::FM_REPLACE);
+    Gosu::Writer writer = file.back_writer();
+    writer.write_pod(PACK_MAGIC, Gosu::BO_LITTLE);
+    writer.write_pod(PACK_VERSION, Gosu::BO_LITTLE);
+    writer.write_pod(static_cast<std::uint32_t>(sources.size()), Gosu::BO_LITTLE);
+    for (const Source& source : sources) {
+        offset = align(offset);
+        writer.write_pod(static_cast<std::uint16_t>(source.name.size()), Gosu::BO_LITTLE);
+        writer.write(source.name.data(), source.name.size());
+        writer.write_pod(source.codec);
+        writer.write_pod(offset, Gosu::BO_LITTLE);
+        writer.write_pod(static_cast<std::uint64_t>(source.bytes.size()), Gosu::BO_LITTLE);
+        writer.write_pod(source.size, Gosu::BO_LITTLE);
+        writer.write_pod(source.hash, Gosu::BO_LITTLE);
+        offset += source.bytes.size();
+    }
+    for (const Source& source : sources) {
+        write_padding(writer, static_cast<std::size_t>(align(writer.position()) - writer.position()));
+        writer.write(source.bytes.data(), source.bytes.size());
+    }
+}
+
+// --- Pack Entry ---
+
+void PackEntry::resize(std::size_t) {
+    throw std::logic_error("Asset pack entries are read-only");
+}
+
+void PackEntry::read(std::size_t offset, std::size_t count, void* dest_buffer) const {
+    if (offset > length || count > length - offset) {
+        throw std::length_error("Read past the end of an asset pack entry");
+    }
+    if (count) std::memcpy(dest_buffer, bytes + offset, count);
+}
+
+void PackEntry::write(std::size_t, std::size_t, const void*) {
+    throw std::logic_error("Asset pack entries are read-only");
+}
+
+// --- Asset Pack ---
+
+AssetPack::AssetPack(const std::string& filename, unsigned threads)
+    : file(filename) {
+    Gosu::Reader reader(file, 0);
+    if (file.size() < 12 || reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != PACK_MAGIC ||
+        reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != PACK_VERSION) {
+        throw std::runtime_error(filename + " is not an asset pack");
+    }
+    std::uint32_t count = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+    entries.resize(count);
+    for (Entry& entry : entries) {
+        entry.name.resize(reader.get_pod<std::uint16_t>(Gosu::BO_LITTLE));
+        reader.read(entry.name.data(), entry.name.size());
+        entry.codec = static_cast<PackCodec>(reader.get_pod<std::uint8_t>());
+        entry.offset = reader.get_pod<std::uint64_t>(Gosu::BO_LITTLE);
+        entry.stored_size = reader.get_pod<std::uint64_t>(Gosu::BO_LITTLE);
+        entry.size = reader.get_pod<std::uint64_t>(Gosu::BO_LITTLE);
+        entry.hash = reader.get_pod<std::uint64_t>(Gosu::BO_LITTLE);
+        if ((entry.codec != PACK_STORED && entry.codec != PACK_LZ4) ||
+            entry.offset > file.size() || entry.stored_size > file.size() - entry.offset ||
+            (entry.codec == PACK_STORED && entry.stored_size != entry.size)) {
+            throw std::runtime_error("Corrupt directory in " + filename);
+        }
+    }
+    if (!std::is_sorted(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) { return a.name < b.name; })) {
+        throw std::runtime_error("Corrupt directory in " + filename);
+    }
+    unpack(threads ? threads : std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void AssetPack::unpack(unsigned threads) {
+    const unsigned char* base = static_cast<const unsigned char*>(file.data());
+
+    // Buffers are allocated up front, so the workers only fill memory nobody else touches.
+    std::vector<Entry*> jobs;
+    for (Entry& entry : entries) {
+        if (entry.codec == PACK_LZ4) {
+            auto buffer = std::make_unique<Gosu::Buffer>();
+            buffer->resize(static_cast<std::size_t>(entry.size));
+            entry.resource = std::move(buffer);
+        }
+        else {
+            entry.resource = std::make_unique<PackEntry>(base + entry.offset,
+                static_cast<std::size_t>(entry.size));
+        }
+        jobs.push_back(&entry);
+    }
+    // Largest first, so one big entry does not start last and keep a single thread busy.
+    std::sort(jobs.begin(), jobs.end(), [](const Entry* a, const Entry* b) { return a->size > b->size; });
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<const Entry*> failed{nullptr};
+    auto work = [&] {
+        while (true) {
+            std::size_t i = next++;
+            if (i >= jobs.size()) return;
+            Entry& entry = *jobs[i];
+            const unsigned char* bytes = base + entry.offset;
+            if (entry.codec == PACK_LZ4 && entry.size > 0) {
+                auto& buffer = static_cast<Gosu::Buffer&>(*entry.resource);
+                unsigned char* out = static_cast<unsigned char*>(buffer.data());
+                if (!lz4_decompress(bytes, static_cast<std::size_t>(entry.stored_size), out, buffer.size())) {
+                    failed = &entry;
+                    continue;
+                }
+                bytes = out;
+            }
+            if (content_hash(bytes, static_cast<std::size_t>(entry.size)) != entry.hash) failed = &entry;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < std::min<std::size_t>(threads, jobs.size()); ++t) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+
+    if (const Entry* entry = failed) throw std::runtime_error("Corrupt asset in pack: " + entry->name);
+}
+
+const AssetPack::Entry* AssetPack::find(const std::string& name) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), name,
+        [](const Entry& entry, const std::string& name) { return entry.name < name; });
+    return it != entries.end() && it->name == name ? &*it : nullptr;
+}
+
+bool AssetPack::contains(const std::string& name) const {
+    return find(name) != nullptr;
+}
+
+const Gosu::Resource& AssetPack::entry(const std::string& name) const {
+    const Entry* entry = find(name);
+    if (!entry) throw std::out_of_range("No asset named " + name);
+    return *entry->resource;
+}
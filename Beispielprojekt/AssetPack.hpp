@@ -0,0 +1,82 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include <Gosu/IO.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Every entry's data starts at a multiple of this, counted from the start of the pack.
+const std::size_t PACK_ALIGNMENT = 64;
+
+enum PackCodec : std::uint8_t {
+    PACK_STORED = 0,
+    PACK_LZ4 = 1 // LZ4 block format
+};
+
+// FNV-1a over the uncompressed bytes of an entry. Pass an earlier result as `hash` to go on
+// over more bytes.
+std::uint64_t content_hash(const void* data, std::size_t size, std::uint64_t hash = 0xcbf29ce484222325);
+
+// Packs the given files into one pack, keyed by their file names (without directories).
+// Each entry is LZ4-compressed unless that does not make it smaller, e.g. for PNGs.
+void build_asset_pack(const std::string& filename, const std::vector<std::string>& files);
+
+// --- Pack Entry: a read-only view of bytes owned by an AssetPack ---
+class PackEntry : public Gosu::Resource {
+    const unsigned char* bytes;
+    std::size_t length;
+
+public:
+    PackEntry(const unsigned char* bytes, std::size_t length) : bytes(bytes), length(length) {}
+
+    std::size_t size() const override { return length; }
+
+    // Entries are read-only; resize and write throw std::logic_error.
+    void resize(std::size_t new_size) override;
+
+    void read(std::size_t offset, std::size_t length, void* dest_buffer) const override;
+
+    void write(std::size_t offset, std::size_t length, const void* source_buffer) override;
+
+    const void* data() const { return bytes; }
+};
+
+// --- Asset Pack: many assets in one memory-mapped file ---
+// Layout (all values BO_LITTLE):
+//   header     magic "APAK", version, entry count
+//   directory  per entry: name length (u16), name, codec (u8),
+//              offset, stored size, size, content hash (u64 each)
+//   data       every entry at a multiple of PACK_ALIGNMENT
+// Opening a pack decompresses all LZ4 entries at once, spread over several threads, and
+// checks every entry's hash. Stored entries are used straight from the mapping.
+class AssetPack {
+    struct Entry {
+        std::string name;
+        PackCodec codec;
+        std::uint64_t offset, stored_size, size, hash;
+        std::unique_ptr<Gosu::Resource> resource;
+    };
+
+    MappedFile file;
+    std::vector<Entry> entries; // sorted by name
+
+    void unpack(unsigned threads);
+    const Entry* find(const std::string& name) const;
+
+public:
+    // threads = 0 uses one thread per hardware thread.
+    explicit AssetPack(const std::string& filename, unsigned threads = 0);
+
+    std::size_t size() const { return entries.size(); }
+    const std::string& name(std::size_t i) const { return entries[i].name; }
+    bool contains(const std::string& name) const;
+
+    // Throws std::out_of_range for an unknown name. The resource lives as long as the pack.
+    const Gosu::Resource& entry(const std::string& name) const;
+
+    // For Gosu::load_image_file(Reader), Gosu::Sample(Reader) and Gosu::Song(Reader).
+    Gosu::Reader reader(const std::string& name) const { return Gosu::Reader(entry(name), 0); }
+};
@@ -0,0 +1,104 @@
+#include "AsyncFile.hpp"
+#include "FrameTiming.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+AsyncFile::AsyncFile(const std::string& filename, std::size_t buffer_size)
+    : file(filename, Gosu::FM_REPLACE) {
+    buffers[0].resize(buffer_size);
+    buffers[1].resize(buffer_size);
+    thread = std::thread([this] { run(); });
+}
+
+AsyncFile::~AsyncFile() {
+    try {
+        flush();
+    }
+    catch (...) {
+        // A destructor must not throw; whatever did not reach the disk is lost.
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+}
+
+void AsyncFile::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [this] { return pending || stopping; });
+        if (!pending) return;
+
+        const char* data = buffers[1 - active].data();
+        std::size_t offset = pending_offset, size = pending_size;
+        lock.unlock();
+        try {
+            file.write(offset, size, data);
+        }
+        catch (...) {
+            lock.lock();
+            error = std::current_exception();
+            lock.unlock();
+        }
+        lock.lock();
+        pending = false;
+        ++stats.flushes;
+        changed.notify_all();
+    }
+}
+
+void AsyncFile::wait_until_idle(std::unique_lock<std::mutex>& lock) {
+    if (pending) {
+        const std::uint64_t start = nanoseconds();
+        changed.wait(lock, [this] { return !pending; });
+        ++stats.stalls;
+        stats.stall_seconds += seconds_since(start);
+    }
+    if (error) std::rethrow_exception(std::exchange(error, nullptr));
+}
+
+void AsyncFile::hand_off() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wait_until_idle(lock);
+    // The other buffer is free now: it becomes the one being filled.
+    pending = true;
+    pending_offset = written;
+    pending_size = fill;
+    written += fill;
+    fill = 0;
+    active = 1 - active;
+    changed.notify_all();
+}
+
+void AsyncFile::resize(std::size_t new_size) {
+    if (new_size < size()) throw std::logic_error("AsyncFile cannot shrink");
+}
+
+void AsyncFile::read(std::size_t, std::size_t, void*) const {
+    throw std::logic_error("AsyncFile is write-only");
+}
+
+void AsyncFile::write(std::size_t offset, std::size_t length, const void* source_buffer) {
+    if (offset != size()) throw std::logic_error("AsyncFile can only append");
+
+    const char* source = static_cast<const char*>(source_buffer);
+    while (length > 0) {
+        std::vector<char>& buffer = buffers[active];
+        std::size_t chunk = std::min(length, buffer.size() - fill);
+        std::memcpy(buffer.data() + fill, source, chunk);
+        fill += chunk;
+        source += chunk;
+        length -= chunk;
+        if (fill == buffer.size()) hand_off();
+    }
+}
+
+void AsyncFile::flush() {
+    if (fill > 0) hand_off();
+    std::unique_lock<std::mutex> lock(mutex);
+    wait_until_idle(lock);
+}
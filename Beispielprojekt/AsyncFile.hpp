@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Gosu/IO.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct AsyncFileStats {
+    std::uint64_t flushes = 0;
+    // Times the caller had to wait because the background thread was still writing.
+    std::uint64_t stalls = 0;
+    double stall_seconds = 0;
+};
+
+// --- Async File: append-only file with the Gosu::Resource interface ---
+// Writes are copied into one of two buffers; a full buffer is handed to a background thread
+// that writes it to disk while the other one is being filled. The caller only ever waits if
+// it fills a whole buffer before the previous one reached the disk.
+// Use it like Gosu::File(filename, FM_REPLACE) through a Gosu::Writer that only appends.
+class AsyncFile : public Gosu::Resource {
+    Gosu::File file;
+    std::vector<char> buffers[2];
+    int active = 0;
+    std::size_t fill = 0;
+    std::size_t written = 0; // bytes handed to the flush thread so far
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool pending = false;
+    bool stopping = false;
+    std::size_t pending_offset = 0, pending_size = 0;
+    std::exception_ptr error;
+    AsyncFileStats stats;
+    std::thread thread;
+
+    void hand_off();
+    void wait_until_idle(std::unique_lock<std::mutex>& lock);
+    void run();
+
+public:
+    explicit AsyncFile(const std::string& filename, std::size_t buffer_size = 1 << 20);
+    ~AsyncFile();
+
+    std::size_t size() const override { return written + fill; }
+
+    // Growing is a no-op (the following write does it); shrinking throws std::logic_error.
+    void resize(std::size_t new_size) override;
+
+    // Write-only: throws std::logic_error.
+    void read(std::size_t offset, std::size_t length, void* dest_buffer) const override;
+
+    // offset must be the current end of the file.
+    void write(std::size_t offset, std::size_t length, const void* source_buffer) override;
+
+    // Hands off everything written so far and waits until it is on disk.
+    void flush();
+
+    const AsyncFileStats& statistics() const { return stats; }
+};
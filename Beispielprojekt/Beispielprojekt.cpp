@@ -1,236 +1,293 @@
 #include <Gosu/Gosu.hpp>
 #include <Gosu/AutoLink.hpp>
-#include <vector>
-#include <memory>
+#include "AssetPack.hpp"
+#include "Bench.hpp"
+#include "Controller.hpp"
+#include "FrameTiming.hpp"
+#include "Ghost.hpp"
+#include "Hud.hpp"
+#include "InputLog.hpp"
+#include "ImageCache.hpp"
+#include "Level.hpp"
+#include "LevelGen.hpp"
+#include "LevelWatcher.hpp"
+#include "Metrics.hpp"
+#include "Particles.hpp"
+#include "Profiler.hpp"
+#include "Replay.hpp"
+#include "World.hpp"
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
 
-// --- Base Object Class ---
-class Objekt {
-public:
-    double x, y, width, height;
-    Objekt(double x, double y, double width, double height)
-        : x(x), y(y), width(width), height(height) {
-    }
-    virtual void draw(Gosu::Graphics& graphics) = 0;
-    virtual ~Objekt() {}
-};
+class GameWindow : public Gosu::Window {
+    World world;
+    std::size_t local_player;
+    std::vector<std::uint8_t> buttons;
+    std::vector<std::uint8_t> recorded_inputs;
+    // An input log only replays from the start of the run in one level; after a reload the
+    // run is no longer written to last_run.inputs.
+    bool level_reloaded = false;
+    std::unique_ptr<ReplayWriter> replay;
 
-// --- Platform Class: Now supports color! ---
-class Platform : public Objekt {
-    Gosu::Color color;
-public:
-    Platform(double x, double y, double width, double height, Gosu::Color color = Gosu::Color::GRAY)
-        : Objekt(x, y, width, height), color(color) {
-    }
-    void draw(Gosu::Graphics& graphics) override {
-        graphics.draw_rect(x, y, width, height, color, 0.0);
-    }
-};
+    // Ghosts replay earlier runs from their precomputed tracks, not by simulating them.
+    std::vector<std::unique_ptr<GhostTrack>> ghost_tracks;
+    std::vector<GhostCursor> ghosts;
 
-// --- Obstacle (Triangle Spike) Class ---
-class Obstacle : public Objekt {
-public:
-    Obstacle(double x, double y, double size) : Objekt(x, y, size, size) {}
-    void draw(Gosu::Graphics& graphics) override {
-        graphics.draw_triangle(
-            x, y + height, Gosu::Color::RED,
-            x + width / 2, y, Gosu::Color::RED,
-            x + width, y + height, Gosu::Color::RED,
-            0.0
-        );
-    }
-};
+    // Images for the tile layer, if the level has one; empty draws plain rectangles.
+    std::vector<Gosu::Image> tileset;
 
-// --- Player Class ---
-class Player : public Objekt {
-public:
-    double velocity_x = 0, velocity_y = 0;
-    bool on_ground = false;
-    const double* world_width;
-    const double* world_height;
-    int jumps_available = 2;
-    double spawn_x, spawn_y;
-    bool jump_in_progress = false;
-
-    Player(double x, double y, const double* ww, const double* wh)
-        : Objekt(x, y, 50, 50), world_width(ww), world_height(wh),
-        spawn_x(x), spawn_y(y) {
-    }
+    // Effects for the world's events; not part of the simulation.
+    ParticleSystem particles;
 
-    void update(
-        const Gosu::Input& input,
-        const std::vector<std::unique_ptr<Platform>>& platforms,
-        Platform* temp_platform
-    ) {
-        const double gravity = 0.5;
-        const double jump_strength = -10.0;
-        const double move_speed = 3.0;
-
-        velocity_x = 0;
-        if (input.down(Gosu::KB_LEFT)) velocity_x -= move_speed;
-        if (input.down(Gosu::KB_RIGHT)) velocity_x += move_speed;
-
-        // Double jump logic
-        if (input.down(Gosu::KB_UP)) {
-            if (jumps_available > 0 && !jump_in_progress) {
-                velocity_y = jump_strength;
-                on_ground = false;
-                jumps_available--;
-                jump_in_progress = true;
-            }
-        }
-        else {
-            jump_in_progress = false;
-        }
+    Hud hud;
+    FrameTimer timer;
+    std::uint32_t last_draw_ops = 0;
 
-        velocity_y += gravity;
+    // Live counters for `--metrics` in another process; null if the segment is unavailable.
+    std::unique_ptr<MetricsPublisher> metrics;
+    MetricsSnapshot metrics_snapshot;
 
-        double next_x = x + velocity_x;
-        double next_y = y + velocity_y;
-        bool on_any_platform = false;
+    KeyboardController keyboard;
 
-        // Include both static and temp platform in collision checks
-        std::vector<const Platform*> all_platforms;
-        for (const auto& plat : platforms) all_platforms.push_back(plat.get());
-        if (temp_platform) all_platforms.push_back(temp_platform);
+    // Picks up edits to the level file while playing; null for the built-in level.
+    std::unique_ptr<LevelWatcher> level_watcher;
 
-        for (const Platform* plat : all_platforms) {
-            bool within_x = next_x + width > plat->x && next_x < plat->x + plat->width;
-            bool falling_onto = y + height <= plat->y && next_y + height >= plat->y;
-            if (within_x && falling_onto && velocity_y >= 0) {
-                next_y = plat->y - height;
-                velocity_y = 0;
-                on_any_platform = true;
+public:
+    // ghost_logs are input logs of earlier runs; each is turned into a track once
+    // (cached next to the log as <log>.ghost until the log or the level changes) and then
+    // played back alongside the player. They must have been recorded in the same level, and
+    // disappear when it is reloaded.
+    // level_file, if not empty, is played instead of the built-in level, and reloaded
+    // whenever it changes.
+    // tile_map, if not empty, adds a tile layer; its tileset is the .png of the same name.
+    GameWindow(const std::vector<std::string>& ghost_logs, const std::string& level_file,
+        const std::string& tile_map)
+        : Gosu::Window(800, 600, false), world(0, 0)
+    {
+        set_caption("2D Sidescroller - AQUA Platform Limited");
+
+        double spawn_x = LEVEL_SPAWN_X, spawn_y = LEVEL_SPAWN_Y;
+        LevelData level;
+        if (level_file.empty()) {
+            build_default_level(world);
+        }
+        else {
+            level = load_level(level_file);
+            build_level(world, level);
+            spawn_x = level.spawn_x;
+            spawn_y = level.spawn_y;
+            level_watcher = std::make_unique<LevelWatcher>(level_file);
+        }
+        if (!tile_map.empty()) {
+            load_tile_layer(world, tile_map);
+            std::filesystem::path images = std::filesystem::path(tile_map).replace_extension(".png");
+            if (std::filesystem::exists(images)) {
+                tileset = Gosu::load_tiles(load_image_cached(images.string()), TILE_SIZE, TILE_SIZE,
+                    Gosu::IF_TILEABLE | Gosu::IF_RETRO);
             }
         }
-
-        x = next_x;
-        y = next_y;
-        on_ground = on_any_platform;
-
-        // World borders
-        if (x < 0) x = 0;
-        if (x + width > *world_width) x = *world_width - width;
-        if (y < 0) y = 0;
-        if (y + height > *world_height) {
-            y = *world_height - height;
-            velocity_y = 0;
-            on_ground = true;
+        local_player = world.add_player(spawn_x, spawn_y);
+        world.record_events = true;
+
+        // Ghosts are simulated in the level being played; their tracks are rebuilt when it changes.
+        const GhostLevel ghost_level{ level_file.empty() ? nullptr : &level, tile_map };
+        for (const std::string& log : ghost_logs) {
+            std::string track = log + ".ghost";
+            update_ghost_track(load_input_log(log), ghost_level, track);
+            ghost_tracks.push_back(std::make_unique<GhostTrack>(track));
         }
+        for (const auto& track : ghost_tracks) ghosts.emplace_back(*track);
 
-        if (on_ground)
-            jumps_available = 2;
-    }
+        replay = std::make_unique<ReplayWriter>("last_run.replay", world);
+        // F2 writes the last zones to profile.json.
+        profiler_set_recording(true);
 
-    void die() {
-        x = spawn_x;
-        y = spawn_y;
-        velocity_x = 0;
-        velocity_y = 0;
-        jumps_available = 2;
-    }
-    void draw(Gosu::Graphics& graphics) override {
-        graphics.draw_rect(x, y, width, height, Gosu::Color::GREEN, 0.0);
+        try {
+            metrics = std::make_unique<MetricsPublisher>();
+        }
+        catch (const std::exception&) {
+            // Metrics are optional; the game runs the same without them.
+        }
     }
-};
 
-bool rects_overlap(const Objekt& a, const Objekt& b) {
-    return a.x < b.x + b.width &&
-        a.x + a.width > b.x &&
-        a.y < b.y + b.height &&
-        a.y + a.height > b.y;
-}
-
-class GameWindow : public Gosu::Window {
-    std::vector<std::unique_ptr<Platform>> platforms;
-    std::vector<std::unique_ptr<Obstacle>> obstacles;
-    std::unique_ptr<Player> player;
-    std::unique_ptr<Platform> temp_platform;
-    unsigned long temp_platform_created = 0;
-    unsigned long temp_platform_last_placed = 0;
-    const unsigned long platform_cooldown = 5000; // 5 seconds
-
-    const double world_width = 2000;
-    const double world_height = 1000;
-
-public:
-    GameWindow()
-        : Gosu::Window(800, 600, false)
-    {
-        set_caption("2D Sidescroller - AQUA Platform Limited");
-
-        player = std::make_unique<Player>(150, 100, &world_width, &world_height);
-
-        platforms.push_back(std::make_unique<Platform>(0, 950, 2000, 50));
-        platforms.push_back(std::make_unique<Platform>(300, 800, 250, 30));
-        platforms.push_back(std::make_unique<Platform>(700, 700, 250, 30));
-        platforms.push_back(std::make_unique<Platform>(1300, 850, 300, 25));
-        platforms.push_back(std::make_unique<Platform>(1700, 600, 200, 30));
-        platforms.push_back(std::make_unique<Platform>(1800, 400, 120, 30));
-        platforms.push_back(std::make_unique<Platform>(100, 650, 180, 20));
-
-        obstacles.push_back(std::make_unique<Obstacle>(500, 920, 40));
-        obstacles.push_back(std::make_unique<Obstacle>(900, 670, 40));
-        obstacles.push_back(std::make_unique<Obstacle>(1350, 820, 40));
-        obstacles.push_back(std::make_unique<Obstacle>(1800, 570, 40));
+    void publish_metrics() {
+        if (std::uint64_t frame_ns = timer.last_frame()) metrics_snapshot.add_frame(frame_ns);
+        if (!metrics || world.tick % (TICKS_PER_SECOND / 2) != 0) return;
+
+        ImageCacheStats cache = image_cache_statistics();
+        metrics_snapshot.published_ns = nanoseconds();
+        metrics_snapshot.ticks = world.tick;
+        metrics_snapshot.image_cache_hits = cache.hits;
+        metrics_snapshot.image_cache_misses = cache.misses;
+        metrics_snapshot.resident_bytes = resident_memory_bytes();
+        metrics_snapshot.draw_ops = last_draw_ops;
+        metrics_snapshot.update_ms = timer.update().percentiles();
+        metrics_snapshot.draw_ms = timer.draw().percentiles();
+        metrics_snapshot.frame_ms = timer.frame().percentiles();
+        metrics->publish(metrics_snapshot);
     }
 
     void update() override {
-        // Platform cooldown/creation
-        static bool down_pressed_last_frame = false;
-
-        if (input().down(Gosu::KB_DOWN)) {
-            if (!down_pressed_last_frame) {
-                bool on_cooldown = (Gosu::milliseconds() - temp_platform_last_placed < platform_cooldown);
-                if (!temp_platform && !on_cooldown) {
-                    double width = 100, height = 15;
-                    double platform_x = player->x + player->width / 2 - width / 2;
-                    double platform_y = player->y + player->height + 2;
-                    temp_platform = std::make_unique<Platform>(
-                        platform_x, platform_y, width, height, Gosu::Color::AQUA
-                    );
-                    temp_platform_created = Gosu::milliseconds();
-                    temp_platform_last_placed = temp_platform_created;
-                }
+        PROFILE_ZONE("update");
+        timer.begin_update();
+        publish_metrics();
+
+        // A new version of the level file replaces the level between two ticks.
+        if (level_watcher) {
+            PROFILE_ZONE("reload level");
+            if (std::unique_ptr<LoadedLevel> level = level_watcher->take()) {
+                reload_level(world, level->data, level->geometry);
+                level_watcher->retire(std::move(level));
+                // Replays store state, not the level, so last_run.replay starts over in the new
+                // level; the finished recording of the old one could not be played back anyway.
+                replay.reset();
+                replay = std::make_unique<ReplayWriter>("last_run.replay", world);
+                level_reloaded = true;
+                recorded_inputs.clear();
+                // Ghost runs were recorded in the old level and would walk through the new one.
+                ghosts.clear();
+                ghost_tracks.clear();
             }
-            down_pressed_last_frame = true;
-        }
-        else {
-            down_pressed_last_frame = false;
+            const std::string error = level_watcher->take_error();
+            if (!error.empty()) std::fprintf(stderr, "Level not reloaded: %s\n", error.c_str());
         }
 
-        // Remove temp platform after 5 seconds
-        if (temp_platform && Gosu::milliseconds() - temp_platform_created > 5000) {
-            temp_platform.reset();
+        // Only the local player is driven by the keyboard; others keep their last input.
+        {
+            PROFILE_ZONE("input");
+            buttons.resize(world.players.size(), 0);
+            buttons[local_player] = keyboard.next(world, local_player);
+            if (!level_reloaded) recorded_inputs.push_back(buttons[local_player]);
         }
+        {
+            PROFILE_ZONE("record replay");
+            replay->record(world, buttons.data());
+        }
+        world.step(buttons.data());
+        particles.emit(world.events);
+        particles.update();
+        {
+            PROFILE_ZONE("ghosts");
+            for (GhostCursor& ghost : ghosts) ghost.advance();
+        }
+        timer.end_update();
+    }
 
-        player->update(input(), platforms, temp_platform.get());
+    void button_down(Gosu::Button button) override {
+        if (button == Gosu::KB_F1) hud.show_performance = !hud.show_performance;
+        else if (button == Gosu::KB_F2) write_chrome_trace("profile.json");
+        else Gosu::Window::button_down(button);
+    }
 
-        // Obstacle collision
-        for (const auto& obstacle : obstacles) {
-            if (rects_overlap(*player, *obstacle)) {
-                player->die();
-            }
-        }
+    void close() override {
+        if (!level_reloaded) save_input_log(recorded_inputs, "last_run.inputs");
+        replay->finish();
+        Gosu::Window::close();
     }
 
     void draw() override {
-        double camera_x = player->x + player->width / 2 - width() / 2;
-        double camera_y = player->y + player->height / 2 - height() / 2;
+        PROFILE_ZONE("draw");
+        timer.begin_draw();
+        const Players& players = world.players;
+        std::uint32_t draw_ops = 0;
+        double camera_x = players.x[local_player] + PLAYER_SIZE / 2 - width() / 2;
+        double camera_y = players.y[local_player] + PLAYER_SIZE / 2 - height() / 2;
 
-        camera_x = std::max(0.0, std::min(camera_x, world_width - width()));
-        camera_y = std::max(0.0, std::min(camera_y, world_height - height()));
+        camera_x = std::max(0.0, std::min(camera_x, world.width - width()));
+        camera_y = std::max(0.0, std::min(camera_y, world.height - height()));
 
         graphics().transform(Gosu::translate(-camera_x, -camera_y), [&] {
-            for (const auto& plat : platforms) plat->draw(graphics());
-            for (const auto& obstacle : obstacles) obstacle->draw(graphics());
-            if (temp_platform) temp_platform->draw(graphics());
-            player->draw(graphics());
+            {
+                PROFILE_ZONE("draw level");
+                const double view_right = camera_x + width(), view_bottom = camera_y + height();
+                auto draw_visible = [&](Objekt& object) {
+                    if (object.y >= view_bottom || object.y + object.height <= camera_y) return;
+                    object.draw(graphics());
+                    ++draw_ops;
+                };
+                world.geometry.for_each_platform_between(camera_x, view_right, draw_visible);
+                world.geometry.for_each_obstacle_between(camera_x, view_right, draw_visible);
+                if (world.tiles) {
+                    draw_ops += world.tiles->draw(tileset, camera_x, camera_y,
+                        camera_x + width(), camera_y + height(), 0.0);
+                }
+            }
+            PROFILE_ZONE("draw players");
+            const TempPlatforms& temp = world.temp_platforms.columns;
+            for (std::size_t k = 0; k < world.temp_platforms.size(); ++k) {
+                graphics().draw_rect(temp.x[k], temp.y[k],
+                    TEMP_PLATFORM_WIDTH, TEMP_PLATFORM_HEIGHT, Gosu::Color::AQUA, 0.0);
+            }
+            draw_ops += static_cast<std::uint32_t>(world.temp_platforms.size());
+            draw_ops += particles.draw(camera_x, camera_y, camera_x + width(), camera_y + height(), 0.0);
+            for (const GhostCursor& ghost : ghosts) {
+                graphics().draw_rect(ghost.x(), ghost.y(), PLAYER_SIZE, PLAYER_SIZE,
+                    Gosu::Color(0x60, 0x00, 0xff, 0x00), 0.0, Gosu::BM_ADD);
+            }
+            for (std::size_t i = 0; i < players.size(); ++i) {
+                graphics().draw_rect(players.x[i], players.y[i], PLAYER_SIZE, PLAYER_SIZE,
+                    Gosu::Color::GREEN, 0.0);
+            }
+            draw_ops += static_cast<std::uint32_t>(ghosts.size() + players.size());
             });
+
+        // The HUD shows the previous frame's counts; this frame's are only known afterwards.
+        {
+            PROFILE_ZONE("draw hud");
+            draw_ops += hud.draw(world, local_player, timer, last_draw_ops);
+        }
+        last_draw_ops = draw_ops;
+        timer.end_draw();
     }
 };
 
-int main() {
-    GameWindow window;
+// --generate-level out.level objects [seed]
+static int generate_level_file(const std::string& filename, const std::string& objects, const std::string& seed) {
+    const auto start = std::chrono::steady_clock::now();
+    const LevelData level = generate_level(std::stoull(seed), std::stoull(objects));
+    const auto generated = std::chrono::steady_clock::now();
+    save_level(level, filename);
+    const auto saved = std::chrono::steady_clock::now();
+    std::printf("%zu platforms, %zu spikes, %.0f px wide: generated in %.0f ms, written in %.0f ms\n",
+        level.platform_count(), level.obstacle_count(), level.width,
+        std::chrono::duration<double, std::milli>(generated - start).count(),
+        std::chrono::duration<double, std::milli>(saved - generated).count());
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "--bench-rollback") return run_rollback_benchmark();
+    if (!args.empty() && args[0] == "--bench-recorder") return run_recorder_benchmark();
+    if (!args.empty() && args[0] == "--bench-replay") return run_replay_benchmark();
+    if (!args.empty() && args[0] == "--bench-particles") return run_particle_benchmark();
+    if (!args.empty() && args[0] == "--bench-bots") return run_bot_benchmark();
+    if (!args.empty() && args[0] == "--bench-env") return run_env_benchmark();
+    if (!args.empty() && args[0] == "--metrics") return run_metrics_reader();
+    if (args.size() >= 2 && args[0] == "--build-pack") {
+        // --build-pack assets.pack rakete.png ...
+        build_asset_pack(args[1], std::vector<std::string>(args.begin() + 2, args.end()));
+        return 0;
+    }
+
+    if (args.size() >= 3 && args[0] == "--generate-level") {
+        return generate_level_file(args[1], args[2], args.size() >= 4 ? args[3] : "1");
+    }
+
+    // --level file.level plays a level file, --tiles level.txt adds a tile layer to the
+    // level; everything else is ghost logs.
+    std::string level_file, tile_map;
+    while (args.size() >= 2 && (args[0] == "--level" || args[0] == "--tiles")) {
+        (args[0] == "--level" ? level_file : tile_map) = args[1];
+        args.erase(args.begin(), args.begin() + 2);
+    }
+
+    GameWindow window(args, level_file, tile_map);
     window.show();
 }
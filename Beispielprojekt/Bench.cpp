@@ -0,0 +1,361 @@
+#include "Bench.hpp"
+#include "AsyncFile.hpp"
+#include "Bot.hpp"
+#include "Controller.hpp"
+#include "FrameTiming.hpp"
+#include "Level.hpp"
+#include "LevelGen.hpp"
+#include "Netcode.hpp"
+#include "Particles.hpp"
+#include "Replay.hpp"
+#include "Snapshot.hpp"
+#include "VecEnv.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool run_rollback_case(std::size_t peers, NetworkConditions conditions, std::uint32_t ticks) {
+    std::vector<std::unique_ptr<World>> worlds;
+    std::vector<std::unique_ptr<RollbackSession>> sessions;
+    std::vector<RandomController> bots;
+    LoopbackNetwork network(peers, conditions);
+
+    for (std::size_t i = 0; i < peers; ++i) {
+        worlds.push_back(std::make_unique<World>(0, 0));
+        build_default_level(*worlds.back());
+        for (std::size_t p = 0; p < peers; ++p) {
+            worlds.back()->add_player(LEVEL_SPAWN_X + 100.0 * p, LEVEL_SPAWN_Y);
+        }
+        sessions.push_back(std::make_unique<RollbackSession>(*worlds.back(), network.endpoint(i), i));
+        bots.emplace_back(static_cast<std::uint32_t>(i + 1));
+    }
+
+    const std::uint64_t start = nanoseconds();
+    std::uint64_t rounds = 0;
+    for (bool running = true; running; ++rounds) {
+        running = false;
+        for (std::size_t i = 0; i < peers; ++i) {
+            if (worlds[i]->tick < ticks) {
+                // A stalled peer retries the same tick next round with the same input.
+                RandomController saved = bots[i];
+                if (!sessions[i]->advance(bots[i].next(*worlds[i], i))) bots[i] = saved;
+                running = true;
+            }
+            else {
+                sessions[i]->poll();
+                running |= sessions[i]->confirmed_tick() < ticks;
+            }
+        }
+        network.advance();
+    }
+    double seconds = seconds_since(start);
+
+    // Every input is confirmed now, so all peers must agree bit for bit.
+    std::vector<unsigned char> first(snapshot_size(*worlds[0])), other(first.size());
+    save_snapshot(*worlds[0], first.data());
+    bool in_sync = true;
+    for (std::size_t i = 1; i < peers; ++i) {
+        save_snapshot(*worlds[i], other.data());
+        in_sync &= first == other;
+    }
+
+    RollbackStats total;
+    for (const auto& session : sessions) {
+        const RollbackStats& s = session->statistics();
+        total.ticks += s.ticks;
+        total.stalls += s.stalls;
+        total.rollbacks += s.rollbacks;
+        total.resimulated_ticks += s.resimulated_ticks;
+        total.resimulation_seconds += s.resimulation_seconds;
+    }
+    std::printf("%zu peers, latency %2u+-%u ticks, loss %4.1f%%: %s, %llu rounds, "
+        "%.2f rollbacks/tick, %.2f resimulated ticks/tick, %.0f resimulated ticks/s, %.0f ticks/s\n",
+        peers, conditions.latency_ticks, conditions.jitter_ticks, conditions.packet_loss * 100,
+        in_sync ? "in sync" : "DESYNC", static_cast<unsigned long long>(rounds),
+        static_cast<double>(total.rollbacks) / total.ticks,
+        static_cast<double>(total.resimulated_ticks) / total.ticks,
+        total.resimulation_seconds > 0 ? total.resimulated_ticks / total.resimulation_seconds : 0.0,
+        total.ticks / seconds);
+    return in_sync;
+}
+
+int run_rollback_benchmark() {
+    const std::uint32_t ticks = 60 * TICKS_PER_SECOND;
+    const NetworkConditions cases[] = {
+        { 0, 0, 0 },
+        { 2, 1, 0.01 },
+        { 4, 2, 0.05 },
+        { 6, 3, 0.15 },
+    };
+    bool ok = true;
+    for (std::size_t peers : { 2, 4, 8 }) {
+        for (const NetworkConditions& conditions : cases) {
+            ok &= run_rollback_case(peers, conditions, ticks);
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// Adds the time spent inside ReplayWriter::record to times, once per tick, and returns the sum.
+static std::uint64_t record_ticks(Gosu::Resource& sink, std::uint32_t ticks, RollingTimes& times) {
+    World world(0, 0);
+    build_default_level(world);
+    std::vector<RandomController> bots;
+    for (std::uint32_t p = 0; p < 8; ++p) {
+        world.add_player(LEVEL_SPAWN_X + 100.0 * p, LEVEL_SPAWN_Y);
+        bots.emplace_back(p + 1);
+    }
+    std::vector<std::uint8_t> buttons(world.players.size());
+    std::uint64_t total = 0;
+
+    ReplayWriter replay(sink, world);
+    for (std::uint32_t t = 0; t < ticks; ++t) {
+        for (std::size_t p = 0; p < buttons.size(); ++p) buttons[p] = bots[p].next(world, p);
+        const std::uint64_t start = nanoseconds();
+        replay.record(world, buttons.data());
+        const std::uint64_t duration = nanoseconds() - start;
+        times.add(duration);
+        total += duration;
+        world.step(buttons.data());
+    }
+    replay.finish();
+    return total;
+}
+
+static void print_record_times(const char* name, const RollingTimes& times, std::uint64_t record_ns,
+    double total) {
+    TimingPercentiles ms = times.percentiles();
+    std::printf("%-10s record: total %8.1f ms, p50 %6.2f us, p99 %6.2f us, max %8.1f us "
+        "(whole run %.1f ms)\n", name, record_ns * 1e-6, ms.p50 * 1e3, ms.p99 * 1e3, ms.max * 1e3,
+        total * 1e3);
+}
+
+int run_recorder_benchmark() {
+    const std::uint32_t ticks = 1000000;
+    const std::string async_name = "bench_recorder_async.replay";
+    const std::string file_name = "bench_recorder_file.replay";
+
+    std::uint64_t start = nanoseconds();
+    RollingTimes async_times(ticks);
+    std::uint64_t async_record_ns;
+    AsyncFileStats stats;
+    {
+        AsyncFile file(async_name);
+        async_record_ns = record_ticks(file, ticks, async_times);
+        file.flush();
+        stats = file.statistics();
+    }
+    double async_total = seconds_since(start);
+
+    start = nanoseconds();
+    RollingTimes file_times(ticks);
+    std::uint64_t file_record_ns;
+    {
+        Gosu::File file(file_name, Gosu::FM_REPLACE);
+        file_record_ns = record_ticks(file, ticks, file_times);
+    }
+    double file_total = seconds_since(start);
+
+    std::printf("%u ticks, %llu bytes\n", ticks,
+        static_cast<unsigned long long>(std::filesystem::file_size(async_name)));
+    print_record_times("AsyncFile", async_times, async_record_ns, async_total);
+    std::printf("           %llu flushes, main thread stalled %llu times for %.2f ms\n",
+        static_cast<unsigned long long>(stats.flushes), static_cast<unsigned long long>(stats.stalls),
+        stats.stall_seconds * 1e3);
+    print_record_times("Gosu::File", file_times, file_record_ns, file_total);
+
+    std::filesystem::remove(async_name);
+    std::filesystem::remove(file_name);
+    return 0;
+}
+
+int run_particle_benchmark() {
+    const std::uint32_t ticks = 10 * TICKS_PER_SECOND;
+    const std::size_t target = 100000;
+    ParticleSystem particles;
+    ParticleBurst burst = { 1000, 500, 1000, 0, 6.2831853f, 1, 7, 0.15f, 70, 5, Gosu::Color::WHITE };
+
+    // Warm up with staggered ages, so particles keep retiring every tick of the measurement.
+    for (std::uint32_t tick = 0; tick < burst.life; ++tick) {
+        burst.count = static_cast<std::uint32_t>(target / burst.life * 2);
+        particles.emit(burst);
+        particles.update();
+    }
+    burst.count = 1000;
+
+    RollingTimes times(ticks);
+    std::size_t smallest = particles.size();
+    for (std::uint32_t tick = 0; tick < ticks; ++tick) {
+        std::uint64_t start = nanoseconds();
+        while (particles.size() < target) particles.emit(burst);
+        particles.update();
+        times.add(nanoseconds() - start);
+        smallest = std::min(smallest, particles.size());
+    }
+
+    TimingPercentiles ms = times.percentiles();
+    std::printf("%u ticks, at least %zu live particles after each update\n", ticks, smallest);
+    std::printf("emit + update per tick: p50 %.3f ms, p99 %.3f ms, max %.3f ms (%.1f%% of a 60 Hz frame at p99)\n",
+        ms.p50, ms.p99, ms.max, ms.p99 / (1000.0 / TICKS_PER_SECOND) * 100);
+    return 0;
+}
+
+int run_bot_benchmark() {
+    // Random players on the built-in level, one world per hardware thread.
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t players = 64;
+    const std::uint32_t ticks = 20000;
+    auto play = [&](unsigned thread) {
+        World world(0, 0);
+        build_default_level(world);
+        std::vector<RandomController> bots;
+        for (std::size_t p = 0; p < players; ++p) {
+            world.add_player(LEVEL_SPAWN_X + 20.0 * p, LEVEL_SPAWN_Y);
+            bots.emplace_back(static_cast<std::uint32_t>(thread * players + p + 1));
+        }
+        std::vector<Controller*> controllers;
+        for (RandomController& bot : bots) controllers.push_back(&bot);
+        run_controllers(world, controllers, ticks);
+    };
+    std::uint64_t start = nanoseconds();
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t) workers.emplace_back(play, t);
+    play(0);
+    for (std::thread& worker : workers) worker.join();
+    double seconds = seconds_since(start);
+    std::printf("random bots: %u worlds x %zu players x %u ticks, %.1f M player ticks/s\n",
+        threads, players, ticks, threads * players * ticks / seconds * 1e-6);
+
+    // Path bots through a generated level, to the entry of its last chunk.
+    const LevelData level = generate_level(1, 640);
+    World world(0, 0);
+    build_level(world, level);
+    NavGraph graph;
+    graph.build(platform_surfaces(world), obstacle_hazards(world));
+    const std::size_t last = graph.chunk_count() - 1;
+    std::uint32_t goal = NAV_NO_NODE;
+    for (std::uint32_t node : graph.chunk_nodes(last)) {
+        if (graph.surface(node).x == static_cast<double>(last) * LEVEL_CHUNK_WIDTH) goal = node;
+    }
+    std::vector<std::unique_ptr<PathBot>> bots;
+    std::vector<Controller*> controllers;
+    for (std::size_t p = 0; p < 16; ++p) {
+        world.add_player(level.spawn_x, level.spawn_y);
+        bots.push_back(std::make_unique<PathBot>(graph, goal));
+        controllers.push_back(bots.back().get());
+    }
+    auto arrived = [&] {
+        return static_cast<std::size_t>(std::count_if(bots.begin(), bots.end(),
+            [](const auto& bot) { return bot->arrived(); }));
+    };
+    start = nanoseconds();
+    std::uint32_t tick = 0;
+    for (; tick < 10 * 60 * TICKS_PER_SECOND && arrived() < bots.size(); tick += TICKS_PER_SECOND) {
+        run_controllers(world, controllers, TICKS_PER_SECOND);
+    }
+    seconds = seconds_since(start);
+    std::uint64_t plans = 0;
+    for (const auto& bot : bots) plans += bot->plan_count();
+    std::printf("path bots: %zu of %zu reached x %.0f within %u ticks, %llu plans, %.2f M player ticks/s\n",
+        arrived(), bots.size(), graph.surface(goal).x, tick, static_cast<unsigned long long>(plans),
+        bots.size() * tick / seconds * 1e-6);
+    return arrived() == bots.size() ? 0 : 1;
+}
+
+int run_env_benchmark() {
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t envs = ENV_SHARD_SIZE * 4 * threads;
+    const int steps = 2000;
+    // Precomputed rows of random actions, so the benchmark measures the environment only.
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> button(0, 15);
+    std::vector<std::vector<std::uint8_t>> actions(64, std::vector<std::uint8_t>(envs));
+    for (auto& row : actions) {
+        for (std::uint8_t& a : row) a = static_cast<std::uint8_t>(button(rng));
+    }
+
+    const LevelData generated = generate_level(1, 640);
+    for (const LevelData* level : { static_cast<const LevelData*>(nullptr), &generated }) {
+        VecEnv env(level, envs, EnvConfig(), threads);
+        std::uint64_t done = 0;
+        const std::uint64_t start = nanoseconds();
+        for (int s = 0; s < steps; ++s) {
+            env.step(actions[s % actions.size()].data());
+            for (std::size_t e = 0; e < envs; ++e) done += env.terminated_data()[e] | env.truncated_data()[e];
+        }
+        const double seconds = seconds_since(start);
+        const double rate = envs * steps / seconds;
+        std::printf("%s level: %zu envs on %u threads, %.2f M env steps/s (%.0f k per thread), %llu episodes ended\n",
+            level ? "generated" : "built-in", envs, threads, rate * 1e-6, rate / threads * 1e-3,
+            static_cast<unsigned long long>(done));
+    }
+    return 0;
+}
+
+int run_replay_benchmark() {
+    const std::uint32_t ticks = 100000;
+    const std::string name = "bench_replay.replay";
+    auto make_world = [](World& world) {
+        build_default_level(world);
+        for (std::uint32_t p = 0; p < 8; ++p) world.add_player(LEVEL_SPAWN_X + 100.0 * p, LEVEL_SPAWN_Y);
+    };
+
+    // Record a bot session, keeping the state at a few hundred random ticks to compare with.
+    std::mt19937 rng(7);
+    std::vector<std::uint32_t> sample_ticks(256);
+    for (std::uint32_t& tick : sample_ticks) tick = static_cast<std::uint32_t>(rng() % ticks);
+    std::sort(sample_ticks.begin(), sample_ticks.end());
+    sample_ticks.erase(std::unique(sample_ticks.begin(), sample_ticks.end()), sample_ticks.end());
+    std::vector<std::vector<unsigned char>> samples;
+    {
+        World world(0, 0);
+        make_world(world);
+        std::vector<RandomController> bots;
+        for (std::uint32_t p = 0; p < 8; ++p) bots.emplace_back(p + 1);
+        std::vector<std::uint8_t> buttons(world.players.size());
+        ReplayWriter replay(name, world);
+        for (std::uint32_t t = 0; t < ticks; ++t) {
+            if (samples.size() < sample_ticks.size() && sample_ticks[samples.size()] == world.tick) {
+                samples.emplace_back(snapshot_size(world));
+                save_snapshot(world, samples.back().data());
+            }
+            for (std::size_t p = 0; p < buttons.size(); ++p) buttons[p] = bots[p].next(world, p);
+            replay.record(world, buttons.data());
+            world.step(buttons.data());
+        }
+        replay.finish();
+    }
+
+    // Seek to the sampled ticks in random order, then play on through the next keyframe,
+    // which check_keyframes compares with the recording.
+    ReplayReader reader(name);
+    reader.check_keyframes = true;
+    World world(0, 0);
+    make_world(world);
+    std::vector<std::size_t> order(samples.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    RollingTimes seek_times(order.size());
+    std::vector<unsigned char> state(snapshot_size(world));
+    std::size_t mismatches = 0;
+    for (std::size_t i : order) {
+        const std::uint64_t start = nanoseconds();
+        reader.seek(world, sample_ticks[i]);
+        seek_times.add(nanoseconds() - start);
+        save_snapshot(world, state.data());
+        mismatches += state != samples[i];
+        for (std::uint32_t t = 0; t < REPLAY_KEYFRAME_INTERVAL && reader.step(world); ++t) {}
+    }
+    std::filesystem::remove(name);
+
+    TimingPercentiles ms = seek_times.percentiles();
+    std::printf("%u ticks, keyframe every %u: %zu seeks, %zu states differ, keyframes after each match\n",
+        ticks, REPLAY_KEYFRAME_INTERVAL, order.size(), mismatches);
+    std::printf("seek: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", ms.p50, ms.p99, ms.max);
+    return mismatches ? 1 : 0;
+}
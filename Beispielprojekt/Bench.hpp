@@ -0,0 +1,27 @@
+#pragma once
+
+// --- Benchmarks: run headless from the command line, e.g. "Beispielprojekt --bench-rollback" ---
+
+// Plays bot sessions over the loopback network under several latency/jitter/loss settings,
+// checks that all peers end in the same state and reports rollback throughput.
+int run_rollback_benchmark();
+
+// Records 1M ticks of an 8-player bot session into a replay, once through AsyncFile and once
+// through a plain Gosu::File, and reports how long the simulation thread was blocked.
+int run_recorder_benchmark();
+
+// Keeps about 100k particles alive for 10 seconds of ticks and reports the cost of
+// ParticleSystem::update per tick against the 16.7 ms frame budget.
+int run_particle_benchmark();
+
+// Steps RandomController players in one world per hardware thread, then PathBots through a
+// generated level, and reports player ticks per second without any Gosu input in the loop.
+int run_bot_benchmark();
+
+// Steps a VecEnv of 1024 environments per hardware thread with random actions, on the
+// built-in and on a generated level, and reports environment steps per second.
+int run_env_benchmark();
+
+// Records a 100k-tick bot session, seeks the ReplayReader to random ticks, checks every
+// state against the recording and its next keyframe, and reports seek times.
+int run_replay_benchmark();
@@ -0,0 +1,156 @@
+#include "Bot.hpp"
+#include <algorithm>
+#include <cmath>
+
+PathBot::PathBot(NavGraph& graph, std::uint32_t goal) : graph(graph), goal(goal) {
+}
+
+bool PathBot::plan(std::uint32_t node) {
+    ++plans;
+    lost = !graph.find_path(node, goal, path);
+    step = 1;
+    return !lost;
+}
+
+// Pressing the direction that brings x into [low, high], or nothing once it is there.
+static std::uint8_t steer(double x, double low, double high) {
+    if (high < low) low = high = (low + high) / 2;
+    if (x + MOVE_SPEED / 2 < low) return BUTTON_RIGHT;
+    if (x - MOVE_SPEED / 2 > high) return BUTTON_LEFT;
+    return 0;
+}
+
+std::uint8_t PathBot::on_ground(const World& world, std::size_t i) {
+    const Players& p = world.players;
+    const double x = p.x[i], feet = p.y[i] + PLAYER_SIZE;
+    placed = false;
+
+    // Where the bot stands: a platform of the graph or its own AQUA platform.
+    const std::uint32_t node = graph.node_under(p.x[i], p.y[i]);
+    if (node != NAV_NO_NODE) {
+        if (node == goal) {
+            step = path.size();
+            if (path.empty()) path.push_back(goal);
+            return 0;
+        }
+        // Standing across two platforms counts as standing on the one ahead.
+        const Surface* ahead = step < path.size() ? &graph.surface(path[step]) : nullptr;
+        const bool expected = ahead && (node == path[step] || (std::abs(ahead->y - feet) < 0.5 &&
+            x + PLAYER_SIZE > ahead->x && x < ahead->x + ahead->width));
+        const bool staying = step > 0 && step <= path.size() && node == path[step - 1];
+        if (expected) ++step;
+        else if (!staying && !plan(node)) return 0;
+        if (arrived()) return 0;
+        from = graph.surface(expected ? path[step - 1] : node);
+    }
+    else {
+        const TempPlatforms& temp = world.temp_platforms.columns;
+        bool found = false;
+        for (std::size_t k = 0; k < world.temp_platforms.size() && !found; ++k) {
+            found = temp.owner[k] == i && std::abs(temp.y[k] - feet) < 0.5 &&
+                x + PLAYER_SIZE > temp.x[k] && x < temp.x[k] + TEMP_PLATFORM_WIDTH;
+            if (found) from = Surface{ temp.x[k], temp.y[k], TEMP_PLATFORM_WIDTH };
+        }
+        // On the floor, on tiles or off the plan: head for the nearest platform that leads on
+        // to the goal, again on every tick, since where the bot stands decides which that is.
+        if (!found || step >= path.size()) {
+            if (!found) {
+                // On the floor, as far either way as no move from it reaches and no obstacle
+                // is in the way.
+                Surface ground{ x, feet, PLAYER_SIZE };
+                if (feet >= world.height - 0.5) {
+                    const double left = std::max(0.0, x - LEVEL_CHUNK_WIDTH);
+                    ground = Surface{ left, world.height, std::min(world.width, x + PLAYER_SIZE + LEVEL_CHUNK_WIDTH) - left };
+                }
+                from = clear_span(ground, x, graph.hazards_near(ground));
+            }
+            // A lost bot stands still, so the answer would be the same as last time.
+            if (lost && x == lost_x) return 0;
+            const std::uint32_t entry = graph.entry_node(from, x, goal);
+            if (entry == NAV_NO_NODE) {
+                lost = true;
+                lost_x = x;
+                return 0;
+            }
+            if (step != 0 || path.empty() || path.front() != entry) {
+                if (!plan(entry)) return 0;
+                step = 0;
+            }
+        }
+    }
+
+    target = graph.surface(path[step]);
+    double ticks;
+    if (!find_move(from, target, graph.use_temp_platforms, graph.hazards_near(from), move, ticks)) {
+        lost = true;
+        return 0;
+    }
+
+    // Left edges at which the player stands on each surface; land with some room to spare.
+    const double from_left = from.x - PLAYER_SIZE, from_right = from.x + from.width;
+    const double to_left = target.x - PLAYER_SIZE, to_right = target.x + target.width;
+    const double margin = std::min(10.0, (to_right - to_left) / 2 - 1);
+    const double gap = std::max(to_left - from_right, from_left - to_right);
+    const double direction = target.x + target.width / 2 < from.x + from.width / 2 ? -1 : 1;
+
+    switch (move) {
+    case NAV_WALK:
+        return steer(x, to_left + margin, to_right - margin);
+    case NAV_FALL:
+        // Off the edge the target sticks out past, or the one facing it.
+        if (gap < 0) return to_right - from_right >= 1 ? BUTTON_RIGHT : BUTTON_LEFT;
+        return direction > 0 ? BUTTON_RIGHT : BUTTON_LEFT;
+    default:
+        break;
+    }
+
+    if (move == NAV_TEMP_PLATFORM) {
+        const bool on_cooldown = world.tick - p.temp_platform_last_placed[i] < world.temp_platform_rules.cooldown;
+        if (on_cooldown || p.temp_platform_count[i] >= world.temp_platform_rules.per_player) return 0;
+    }
+    // UP has to be let go for a tick before it jumps again.
+    const std::uint8_t up = p.jump_in_progress[i] ? 0 : BUTTON_UP;
+    std::uint8_t b;
+    if (gap < 0) {
+        // Above: jump straight up from under it.
+        b = steer(x, std::max(from_left, to_left) + margin, std::min(from_right, to_right) - margin);
+        if (!b) b = up;
+    }
+    else if (direction > 0) {
+        b = x + MOVE_SPEED >= from_right ? (BUTTON_RIGHT | up) : BUTTON_RIGHT;
+    }
+    else {
+        b = x - MOVE_SPEED <= from_left ? (BUTTON_LEFT | up) : BUTTON_LEFT;
+    }
+    if (b & BUTTON_UP) takeoff = world.tick;
+    return b;
+}
+
+std::uint8_t PathBot::in_air(const World& world, std::size_t i) {
+    const Players& p = world.players;
+    const double x = p.x[i], vy = p.velocity_y[i];
+    if (step >= path.size() || lost) return 0;
+
+    std::uint8_t b = 0;
+    if (move == NAV_DOUBLE_JUMP || move == NAV_TEMP_PLATFORM) {
+        // The AQUA platform goes at the highest point, which the timing for that height gives.
+        const double dy = move == NAV_TEMP_PLATFORM ? -jump_height() : target.y - from.y;
+        const int timing = second_jump_timing(dy);
+        if (timing && world.tick - takeoff == static_cast<std::uint32_t>(timing)) b |= BUTTON_UP;
+    }
+    if (move == NAV_TEMP_PLATFORM && vy >= 0 && p.jumps_available[i] == 0 && !placed) {
+        b |= BUTTON_DOWN;
+        placed = true;
+        return b; // and stand still to land on it
+    }
+    if (placed) return b;
+
+    const double to_left = target.x - PLAYER_SIZE, to_right = target.x + target.width;
+    const double margin = std::min(10.0, (to_right - to_left) / 2 - 1);
+    return b | steer(x, to_left + margin, to_right - margin);
+}
+
+std::uint8_t PathBot::next(const World& world, std::size_t player) {
+    if (world.players.on_ground[player]) return on_ground(world, player);
+    return in_air(world, player);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Controller.hpp"
+#include "NavGraph.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- Path Bot: walks, jumps and builds its way along a NavGraph path to a goal platform ---
+// Every move is played with the inputs Jump.hpp assumed for it: take off at the edge facing
+// the next platform, steer over it in the air, jump again at the tick second_jump_timing gives
+// and, for NAV_TEMP_PLATFORM, put an AQUA platform down at the top of the second jump. Whenever the bot
+// stands on a platform the plan did not expect (after a missed jump, or after dying) it plans
+// again from there; on the floor or on tiles, from the nearest platform it can get onto. The
+// graph is searched only then, so bots sharing a graph must run on the thread that owns it.
+class PathBot : public Controller {
+    NavGraph& graph;
+    std::uint32_t goal;
+    std::vector<std::uint32_t> path;
+    std::size_t step = 0;   // path[step] is where the bot is heading; 0 while getting back onto the graph
+    Surface from{}, target{}; // of the move being made
+    NavEdgeKind move = NAV_WALK;
+    std::uint32_t takeoff = 0; // world tick of the first jump
+    bool placed = false;    // AQUA platform of this move is down
+    bool lost = false;      // no path from where the bot stands, for now
+    double lost_x = -1;     // where the bot last found no way back onto the graph
+    std::uint64_t plans = 0;
+
+    bool plan(std::uint32_t node);
+    std::uint8_t on_ground(const World& world, std::size_t player);
+    std::uint8_t in_air(const World& world, std::size_t player);
+
+public:
+    PathBot(NavGraph& graph, std::uint32_t goal);
+
+    bool arrived() const { return !path.empty() && step >= path.size(); }
+    bool stuck() const { return lost; }
+    std::uint64_t plan_count() const { return plans; }
+
+    std::uint8_t next(const World& world, std::size_t player) override;
+};
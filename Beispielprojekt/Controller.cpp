@@ -0,0 +1,39 @@
+#include "Controller.hpp"
+#include <Gosu/Input.hpp>
+#include <stdexcept>
+#include <utility>
+
+std::uint8_t KeyboardController::next(const World&, std::size_t) {
+    std::uint8_t b = 0;
+    if (Gosu::Input::down(Gosu::KB_LEFT)) b |= BUTTON_LEFT;
+    if (Gosu::Input::down(Gosu::KB_RIGHT)) b |= BUTTON_RIGHT;
+    if (Gosu::Input::down(Gosu::KB_UP)) b |= BUTTON_UP;
+    if (Gosu::Input::down(Gosu::KB_DOWN)) b |= BUTTON_DOWN;
+    return b;
+}
+
+ReplayController::ReplayController(std::vector<std::uint8_t> inputs) : inputs(std::move(inputs)) {
+}
+
+std::uint8_t ReplayController::next(const World&, std::size_t) {
+    return position < inputs.size() ? inputs[position++] : 0;
+}
+
+std::uint8_t RandomController::next(const World&, std::size_t) {
+    if (remaining-- <= 0) {
+        held = static_cast<std::uint8_t>(rng() & (BUTTON_LEFT | BUTTON_RIGHT | BUTTON_UP | BUTTON_DOWN));
+        remaining = 5 + static_cast<int>(rng() % 30);
+    }
+    return held;
+}
+
+void run_controllers(World& world, std::span<Controller* const> controllers, std::uint32_t ticks) {
+    if (controllers.size() != world.players.size()) {
+        throw std::invalid_argument("Every player needs exactly one controller");
+    }
+    std::vector<std::uint8_t> buttons(controllers.size());
+    for (std::uint32_t t = 0; t < ticks; ++t) {
+        for (std::size_t i = 0; i < controllers.size(); ++i) buttons[i] = controllers[i]->next(world, i);
+        world.step(buttons.data());
+    }
+}
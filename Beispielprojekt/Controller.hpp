@@ -0,0 +1,53 @@
+#pragma once
+
+#include "World.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+// --- Controller: decides one player's Buttons mask every tick ---
+// Whatever drives a player goes through this: the keyboard, a recorded log or a bot. The
+// simulation only ever sees the Buttons byte, so headless runs never touch Gosu's input.
+class Controller {
+public:
+    virtual ~Controller() = default;
+
+    // Buttons of `player` for the next World::step, decided on the world before it.
+    virtual std::uint8_t next(const World& world, std::size_t player) = 0;
+};
+
+// The arrow keys. Only meaningful while a Gosu window is open.
+class KeyboardController : public Controller {
+public:
+    std::uint8_t next(const World& world, std::size_t player) override;
+};
+
+// Plays back an input log; nothing is pressed after its end.
+class ReplayController : public Controller {
+    std::vector<std::uint8_t> inputs;
+    std::size_t position = 0;
+
+public:
+    explicit ReplayController(std::vector<std::uint8_t> inputs);
+
+    bool finished() const { return position >= inputs.size(); }
+
+    std::uint8_t next(const World& world, std::size_t player) override;
+};
+
+// Holds a random button combination for a random number of ticks, like a human would.
+class RandomController : public Controller {
+    std::mt19937 rng;
+    std::uint8_t held = 0;
+    int remaining = 0;
+
+public:
+    explicit RandomController(std::uint32_t seed) : rng(seed) {}
+
+    std::uint8_t next(const World& world, std::size_t player) override;
+};
+
+// Steps the world `ticks` times, with controllers[i] playing player i.
+void run_controllers(World& world, std::span<Controller* const> controllers, std::uint32_t ticks);
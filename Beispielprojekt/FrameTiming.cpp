@@ -0,0 +1,43 @@
+#include "FrameTiming.hpp"
+#include <algorithm>
+
+RollingTimes::RollingTimes(std::size_t window)
+    : samples(std::max<std::size_t>(window, 1)), sorted(samples.size()) {
+}
+
+void RollingTimes::add(std::uint64_t duration_ns) {
+    samples[next] = duration_ns;
+    next = (next + 1) % samples.size();
+    count = std::min(count + 1, samples.size());
+}
+
+TimingPercentiles RollingTimes::percentiles() const {
+    TimingPercentiles result;
+    if (count == 0) return result;
+
+    // Nearest-rank percentiles over the current window.
+    std::copy(samples.begin(), samples.begin() + count, sorted.begin());
+    auto end = sorted.begin() + count;
+    std::sort(sorted.begin(), end);
+    auto at = [&](double p) {
+        return sorted[std::min(count - 1, static_cast<std::size_t>(p * count))] * 1e-6;
+    };
+    result.p50 = at(0.50);
+    result.p95 = at(0.95);
+    result.p99 = at(0.99);
+    result.max = sorted[count - 1] * 1e-6;
+    return result;
+}
+
+FrameTimer::FrameTimer(std::size_t window)
+    : update_times(window), draw_times(window), frame_times(window) {
+}
+
+void FrameTimer::begin_update() {
+    update_start = nanoseconds();
+    if (frame_start) {
+        last_frame_ns = update_start - frame_start;
+        frame_times.add(last_frame_ns);
+    }
+    frame_start = update_start;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- Clock: monotonic nanoseconds, for anything finer than Gosu::milliseconds() ---
+// Counts from an unspecified start and does not wrap for centuries, so differences between
+// two readings are always valid.
+inline std::uint64_t nanoseconds() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline double seconds_since(std::uint64_t start_ns) {
+    return (nanoseconds() - start_ns) * 1e-9;
+}
+
+const std::size_t FRAME_TIMING_WINDOW = 300; // five seconds at 60 FPS
+
+// All in milliseconds.
+struct TimingPercentiles {
+    double p50 = 0, p95 = 0, p99 = 0, max = 0;
+};
+
+// --- Rolling Times: the last N durations and their percentiles ---
+// Neither adding nor computing percentiles allocates after construction.
+class RollingTimes {
+    std::vector<std::uint64_t> samples;
+    mutable std::vector<std::uint64_t> sorted;
+    std::size_t next = 0, count = 0;
+
+public:
+    explicit RollingTimes(std::size_t window = FRAME_TIMING_WINDOW);
+
+    void add(std::uint64_t duration_ns);
+    std::size_t size() const { return count; }
+    TimingPercentiles percentiles() const;
+};
+
+// --- Frame Timer: update, draw and whole-frame times of the game loop ---
+class FrameTimer {
+    RollingTimes update_times, draw_times, frame_times;
+    std::uint64_t update_start = 0, draw_start = 0, frame_start = 0, last_frame_ns = 0;
+
+public:
+    explicit FrameTimer(std::size_t window = FRAME_TIMING_WINDOW);
+
+    // A frame runs from one begin_update to the next.
+    void begin_update();
+    void end_update() { update_times.add(nanoseconds() - update_start); }
+    void begin_draw() { draw_start = nanoseconds(); }
+    void end_draw() { draw_times.add(nanoseconds() - draw_start); }
+
+    const RollingTimes& update() const { return update_times; }
+    const RollingTimes& draw() const { return draw_times; }
+    const RollingTimes& frame() const { return frame_times; }
+    // Duration of the frame that the last begin_update ended; 0 before the second frame.
+    std::uint64_t last_frame() const { return last_frame_ns; }
+};
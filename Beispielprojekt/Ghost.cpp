@@ -0,0 +1,168 @@
+#include "Ghost.hpp"
+#include "AssetPack.hpp"
+#include "Level.hpp"
+#include "SpanIO.hpp"
+#include <cmath>
+#include <stdexcept>
+
+static const std::uint32_t GHOST_MAGIC = 0x32534847; // "GHS2"
+static const std::size_t GHOST_HEADER_SIZE = 24;
+static const std::size_t GHOST_KEYFRAME_SIZE = 12;
+
+static std::int32_t quantize(double v) {
+    return static_cast<std::int32_t>(std::lround(v * GHOST_SUBPIXELS));
+}
+
+static void put_varint(std::vector<unsigned char>& out, std::int32_t v) {
+    // Zigzag, so small negative deltas stay small too.
+    std::uint32_t u = (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+    while (u >= 0x80) {
+        out.push_back(static_cast<unsigned char>(u | 0x80));
+        u >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(u));
+}
+
+// Stops at `end` and after the five bytes a 32-bit value takes at most, so a damaged track
+// never reads past its data.
+static std::int32_t get_varint(const unsigned char*& p, const unsigned char* end) {
+    std::uint32_t u = 0;
+    for (int shift = 0; p < end && shift < 35; shift += 7) {
+        const unsigned char byte = *p++;
+        u |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    return static_cast<std::int32_t>(u >> 1) ^ -static_cast<std::int32_t>(u & 1);
+}
+
+static std::uint32_t get_u32(const unsigned char* p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+static std::uint64_t get_u64(const unsigned char* p) {
+    return get_u32(p) | static_cast<std::uint64_t>(get_u32(p + 4)) << 32;
+}
+
+static std::uint64_t ghost_source(const std::vector<std::uint8_t>& inputs, const GhostLevel& level) {
+    std::uint64_t hash = content_hash(inputs.data(), inputs.size());
+    if (const LevelData* data = level.level) {
+        for (double value : { data->width, data->height, data->spawn_x, data->spawn_y }) {
+            hash = content_hash(&value, sizeof(value), hash);
+        }
+        for (const std::vector<double>* field : { &data->platform_x, &data->platform_y, &data->platform_width,
+            &data->platform_height, &data->obstacle_x, &data->obstacle_y, &data->obstacle_size }) {
+            // The count first, so moving an object from one array to the next changes the hash.
+            const std::uint64_t count = field->size();
+            hash = content_hash(&count, sizeof(count), hash);
+            hash = content_hash(field->data(), field->size() * sizeof(double), hash);
+        }
+    }
+    if (!level.tile_map.empty()) {
+        Gosu::Buffer tiles;
+        Gosu::load_file(tiles, level.tile_map);
+        hash = content_hash(tiles.data(), tiles.size(), hash);
+    }
+    return hash;
+}
+
+void build_ghost_track(const std::vector<std::uint8_t>& inputs, const GhostLevel& level, const std::string& filename) {
+    World world(0, 0);
+    if (level.level) build_level(world, *level.level);
+    else build_default_level(world);
+    if (!level.tile_map.empty()) load_tile_layer(world, level.tile_map);
+    world.add_player(level.level ? level.level->spawn_x : LEVEL_SPAWN_X, level.level ? level.level->spawn_y : LEVEL_SPAWN_Y);
+
+    std::vector<std::int32_t> keyframes;
+    std::vector<unsigned char> deltas;
+    std::int32_t qx = quantize(world.players.x[0]), qy = quantize(world.players.y[0]);
+    keyframes.insert(keyframes.end(), { qx, qy, 0 });
+
+    for (std::size_t t = 0; t < inputs.size(); ++t) {
+        world.step(&inputs[t]);
+        std::int32_t nx = quantize(world.players.x[0]), ny = quantize(world.players.y[0]);
+        put_varint(deltas, nx - qx);
+        put_varint(deltas, ny - qy);
+        qx = nx;
+        qy = ny;
+        if ((t + 1) % GHOST_KEYFRAME_INTERVAL == 0) {
+            keyframes.insert(keyframes.end(), { qx, qy, static_cast<std::int32_t>(deltas.size()) });
+        }
+    }
+
+    Gosu::Buffer buffer;
+    Gosu::Writer writer = buffer.back_writer();
+    writer.write_pod(GHOST_MAGIC, Gosu::BO_LITTLE);
+    writer.write_pod(static_cast<std::uint32_t>(inputs.size() + 1), Gosu::BO_LITTLE);
+    writer.write_pod(GHOST_KEYFRAME_INTERVAL, Gosu::BO_LITTLE);
+    writer.write_pod(static_cast<std::uint32_t>(keyframes.size() / 3), Gosu::BO_LITTLE);
+    writer.write_pod(ghost_source(inputs, level), Gosu::BO_LITTLE);
+    write_span<std::int32_t>(writer, keyframes, Gosu::BO_LITTLE);
+    if (!deltas.empty()) writer.write(deltas.data(), deltas.size());
+    Gosu::save_file(buffer, filename);
+}
+
+void update_ghost_track(const std::vector<std::uint8_t>& inputs, const GhostLevel& level, const std::string& filename) {
+    try {
+        if (GhostTrack(filename).source_hash() == ghost_source(inputs, level)) return;
+    }
+    catch (const std::exception&) {
+        // Missing, from an older version or damaged: built again below.
+    }
+    build_ghost_track(inputs, level, filename);
+}
+
+GhostTrack::GhostTrack(const std::string& filename)
+    : storage(filename) {
+    if (storage.size() < GHOST_HEADER_SIZE) {
+        throw std::runtime_error("Ghost track too short: " + filename);
+    }
+    const unsigned char* base = static_cast<const unsigned char*>(storage.data());
+    if (get_u32(base) != GHOST_MAGIC) {
+        throw std::runtime_error("Not a ghost track: " + filename);
+    }
+    samples = get_u32(base + 4);
+    keyframe_interval = get_u32(base + 8);
+    keyframe_count = get_u32(base + 12);
+    source = get_u64(base + 16);
+    if (samples == 0 || keyframe_interval == 0 ||
+        keyframe_count != (samples - 1) / keyframe_interval + 1 ||
+        storage.size() < GHOST_HEADER_SIZE + keyframe_count * GHOST_KEYFRAME_SIZE) {
+        throw std::runtime_error("Corrupt ghost track: " + filename);
+    }
+    keyframes = base + GHOST_HEADER_SIZE;
+    deltas = keyframes + keyframe_count * GHOST_KEYFRAME_SIZE;
+    deltas_end = base + storage.size();
+    // seek jumps straight to these. A last keyframe on the last sample has no deltas after
+    // it and points at the end.
+    for (std::uint32_t k = 0; k < keyframe_count; ++k) {
+        if (get_u32(keyframes + k * GHOST_KEYFRAME_SIZE + 8) > static_cast<std::size_t>(deltas_end - deltas)) {
+            throw std::runtime_error("Corrupt ghost track: " + filename);
+        }
+    }
+}
+
+GhostCursor::GhostCursor(const GhostTrack& track) : track(&track) {
+    seek(0);
+}
+
+void GhostCursor::seek(std::uint32_t target) {
+    if (target >= track->samples) target = track->samples - 1;
+    std::uint32_t k = target / track->keyframe_interval;
+    const unsigned char* keyframe = track->keyframes + k * GHOST_KEYFRAME_SIZE;
+    sample = k * track->keyframe_interval;
+    qx = static_cast<std::int32_t>(get_u32(keyframe));
+    qy = static_cast<std::int32_t>(get_u32(keyframe + 4));
+    next = track->deltas + get_u32(keyframe + 8);
+    while (sample < target) advance();
+}
+
+void GhostCursor::advance() {
+    if (finished()) return;
+    // Wrapping, as the deltas were taken; a damaged track must not overflow. One that ends
+    // early leaves the ghost standing, and seek still gets to its sample.
+    if (next < track->deltas_end) {
+        qx = static_cast<std::int32_t>(static_cast<std::uint32_t>(qx) + static_cast<std::uint32_t>(get_varint(next, track->deltas_end)));
+        qy = static_cast<std::int32_t>(static_cast<std::uint32_t>(qy) + static_cast<std::uint32_t>(get_varint(next, track->deltas_end)));
+    }
+    ++sample;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Level.hpp"
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Ghost positions are stored in fixed point with this many steps per pixel.
+const int GHOST_SUBPIXELS = 16;
+const std::uint32_t GHOST_KEYFRAME_INTERVAL = 256;
+
+// The level a run was recorded in, as given on the command line.
+struct GhostLevel {
+    const LevelData* level = nullptr; // null: the built-in level
+    std::string tile_map;             // empty: no tile layer
+};
+
+// Simulates a recorded input log once in its level and writes the resulting position track,
+// so playing it back never has to run the physics again.
+void build_ghost_track(const std::vector<std::uint8_t>& inputs, const GhostLevel& level, const std::string& filename);
+// Builds the track unless the file already holds one built from the same inputs and level.
+void update_ghost_track(const std::vector<std::uint8_t>& inputs, const GhostLevel& level, const std::string& filename);
+
+// --- Ghost Track: the positions of one recorded run, one sample per tick ---
+// Layout (little endian): magic, sample count, keyframe interval, keyframe count, u64 hash
+// of the inputs and level it was built from, keyframes { x, y, delta offset }, then zigzag varint (dx, dy) pairs for every later tick.
+class GhostTrack {
+    MappedFile storage;
+    std::uint32_t samples = 0;
+    std::uint32_t keyframe_interval = 0;
+    std::uint32_t keyframe_count = 0;
+    std::uint64_t source = 0;
+    const unsigned char* keyframes = nullptr;
+    const unsigned char* deltas = nullptr;
+    const unsigned char* deltas_end = nullptr;
+
+    friend class GhostCursor;
+
+public:
+    explicit GhostTrack(const std::string& filename);
+
+    // Number of positions, i.e. recorded ticks + 1 (the spawn position).
+    std::uint32_t length() const { return samples; }
+    // Identifies what the track was built from, see update_ghost_track.
+    std::uint64_t source_hash() const { return source; }
+};
+
+// --- Ghost Cursor: decodes one track sequentially, one varint pair per tick ---
+class GhostCursor {
+    const GhostTrack* track;
+    std::uint32_t sample = 0;
+    std::int32_t qx = 0, qy = 0;
+    const unsigned char* next = nullptr;
+
+public:
+    explicit GhostCursor(const GhostTrack& track);
+
+    // Jumps to any sample by starting at the keyframe before it.
+    void seek(std::uint32_t sample);
+    void advance();
+    bool finished() const { return sample + 1 >= track->samples; }
+
+    std::uint32_t position() const { return sample; }
+    double x() const { return static_cast<double>(qx) / GHOST_SUBPIXELS; }
+    double y() const { return static_cast<double>(qy) / GHOST_SUBPIXELS; }
+};
@@ -0,0 +1,65 @@
+#include "Hud.hpp"
+#include <Gosu/Graphics.hpp>
+#include <Gosu/Inspection.hpp>
+#include <cstdio>
+
+static const double HUD_FONT_HEIGHT = 20;
+static const double HUD_MARGIN = 10;
+static const double HUD_BAR_WIDTH = 120;
+static const double HUD_Z = 10;
+static const unsigned HUD_REFRESH_FRAMES = 15;
+
+Hud::Hud()
+    : font(HUD_FONT_HEIGHT) {
+    font.prepare(" !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`"
+        "abcdefghijklmnopqrstuvwxyz{|}~");
+}
+
+std::uint32_t Hud::draw(const World& world, std::size_t player, const FrameTimer& timer,
+    std::uint32_t draw_ops) {
+    const std::size_t quads_before = font.quads_drawn();
+    std::uint32_t rects = 0;
+    char line[96];
+    double y = HUD_MARGIN;
+
+    // Platform cooldown: a bar that fills up again, with the seconds left.
+    const std::uint32_t cooldown = world.temp_platform_rules.cooldown;
+    const std::uint32_t since_placed = world.tick - world.players.temp_platform_last_placed[player];
+    if (since_placed < cooldown) {
+        const std::uint32_t left = cooldown - since_placed;
+        std::snprintf(line, sizeof line, "Platform in %.1f s", left / double(TICKS_PER_SECOND));
+        const double filled = HUD_BAR_WIDTH * since_placed / cooldown;
+        Gosu::Graphics::draw_rect(HUD_MARGIN, y + 4, HUD_BAR_WIDTH, HUD_FONT_HEIGHT - 8,
+            Gosu::Color(0x80, 0x40, 0x40, 0x40), HUD_Z);
+        Gosu::Graphics::draw_rect(HUD_MARGIN, y + 4, filled, HUD_FONT_HEIGHT - 8,
+            Gosu::Color::AQUA, HUD_Z);
+        rects += 2;
+    }
+    else {
+        std::snprintf(line, sizeof line, "Platform ready");
+    }
+    font.draw_text(line, HUD_MARGIN + HUD_BAR_WIDTH + HUD_MARGIN, y, HUD_Z);
+    y += HUD_FONT_HEIGHT;
+
+    if (show_performance) {
+        if (frames_until_refresh-- == 0) {
+            update_ms = timer.update().percentiles();
+            draw_ms = timer.draw().percentiles();
+            frame_ms = timer.frame().percentiles();
+            frames_until_refresh = HUD_REFRESH_FRAMES;
+        }
+        std::snprintf(line, sizeof line, "%d FPS  frame p50 %.2f  p99 %.2f  max %.2f ms  %u draw ops",
+            Gosu::fps(), frame_ms.p50, frame_ms.p99, frame_ms.max, draw_ops);
+        font.draw_text(line, HUD_MARGIN, y, HUD_Z);
+        y += HUD_FONT_HEIGHT;
+        std::snprintf(line, sizeof line, "update p50 %.2f  p95 %.2f  p99 %.2f ms",
+            update_ms.p50, update_ms.p95, update_ms.p99);
+        font.draw_text(line, HUD_MARGIN, y, HUD_Z);
+        y += HUD_FONT_HEIGHT;
+        std::snprintf(line, sizeof line, "draw   p50 %.2f  p95 %.2f  p99 %.2f ms",
+            draw_ms.p50, draw_ms.p95, draw_ms.p99);
+        font.draw_text(line, HUD_MARGIN, y, HUD_Z);
+    }
+
+    return rects + static_cast<std::uint32_t>(font.quads_drawn() - quads_before);
+}
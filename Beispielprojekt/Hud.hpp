@@ -0,0 +1,27 @@
+#pragma once
+
+#include "FrameTiming.hpp"
+#include "TextCache.hpp"
+#include "World.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// --- HUD: platform cooldown and performance counters, drawn in screen space ---
+// Every line is formatted into a fixed char buffer and drawn through a GlyphAtlas whose
+// glyphs are all rasterized in the constructor, so drawing the HUD never allocates.
+class Hud {
+    GlyphAtlas font;
+    // Refreshed a few times per second, so the numbers can be read while they change.
+    TimingPercentiles update_ms, draw_ms, frame_ms;
+    unsigned frames_until_refresh = 0;
+
+public:
+    bool show_performance = true;
+
+    Hud();
+
+    // draw_ops: quads and rectangles handed to Gosu in the previous frame, HUD included.
+    // Returns the number of draw operations it issued itself.
+    std::uint32_t draw(const World& world, std::size_t player, const FrameTimer& timer,
+        std::uint32_t draw_ops);
+};
@@ -0,0 +1,121 @@
+#include "ImageCache.hpp"
+#include "AssetPack.hpp"
+#include "MappedFile.hpp"
+#include "SpanIO.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+
+static const std::uint32_t IMAGE_CACHE_MAGIC = 0x43504d42; // "BMPC"
+static const std::uint32_t IMAGE_CACHE_VERSION = 1;
+static const std::size_t IMAGE_CACHE_HEADER_SIZE = 64;
+
+static std::atomic<std::uint64_t> cache_hits{0}, cache_misses{0};
+
+static_assert(sizeof(Gosu::Color) == 4, "Cached pixels are copied as 4 bytes per Gosu::Color");
+
+static std::string cache_filename(const std::string& cache_dir, std::uint64_t hash) {
+    char name[32];
+    std::snprintf(name, sizeof name, "%016llx.bitmap", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path(cache_dir) / name).string();
+}
+
+// Returns false (and leaves bitmap alone) if there is no usable cache file.
+static bool load_cached_pixels(const std::string& filename, std::uint64_t hash, Gosu::Bitmap& bitmap) {
+    std::error_code error;
+    if (!std::filesystem::exists(filename, error)) return false;
+
+    // A file that cannot be opened or mapped (no permission, a directory, locked by another
+    // instance) is as good as none.
+    try {
+        MappedFile file(filename);
+        if (file.size() < IMAGE_CACHE_HEADER_SIZE) return false;
+        Gosu::Reader reader(file, 0);
+        std::uint32_t magic = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+        std::uint32_t version = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+        std::uint32_t width = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+        std::uint32_t height = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+        std::uint64_t source_hash = reader.get_pod<std::uint64_t>(Gosu::BO_LITTLE);
+        const std::uint64_t pixel_bytes = std::uint64_t(width) * height * sizeof(Gosu::Color);
+        if (magic != IMAGE_CACHE_MAGIC || version != IMAGE_CACHE_VERSION || source_hash != hash ||
+            width > 0x7fffffff || height > 0x7fffffff ||
+            file.size() != IMAGE_CACHE_HEADER_SIZE + pixel_bytes) {
+            return false;
+        }
+
+        Gosu::Bitmap pixels(static_cast<int>(width), static_cast<int>(height));
+        if (pixel_bytes) {
+            std::memcpy(pixels.data(), static_cast<const char*>(file.data()) + IMAGE_CACHE_HEADER_SIZE,
+                static_cast<std::size_t>(pixel_bytes));
+        }
+        bitmap.swap(pixels);
+        return true;
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+}
+
+static void save_cached_pixels(const std::string& filename, std::uint64_t hash, const Gosu::Bitmap& bitmap) {
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path());
+    // Written under a temporary name first, so an interrupted write never leaves a
+    // truncated cache file behind that a later start would trust.
+    const std::string temporary = filename + ".tmp";
+    {
+        Gosu::File file(temporary, Gosu::FM_REPLACE);
+        Gosu::Writer writer = file.back_writer();
+        writer.write_pod(IMAGE_CACHE_MAGIC, Gosu::BO_LITTLE);
+        writer.write_pod(IMAGE_CACHE_VERSION, Gosu::BO_LITTLE);
+        writer.write_pod(static_cast<std::uint32_t>(bitmap.width()), Gosu::BO_LITTLE);
+        writer.write_pod(static_cast<std::uint32_t>(bitmap.height()), Gosu::BO_LITTLE);
+        writer.write_pod(hash, Gosu::BO_LITTLE);
+        static const unsigned char zeros[IMAGE_CACHE_HEADER_SIZE] = {};
+        writer.write(zeros, IMAGE_CACHE_HEADER_SIZE - writer.position());
+        if (bitmap.width() > 0 && bitmap.height() > 0) {
+            writer.write(bitmap.data(), std::size_t(bitmap.width()) * bitmap.height() * sizeof(Gosu::Color));
+        }
+    }
+    std::filesystem::rename(temporary, filename);
+}
+
+Gosu::Bitmap load_image_cached(const Gosu::Resource& source, const std::string& cache_dir) {
+    const unsigned char* bytes = contiguous_data(source);
+    Gosu::Buffer copy;
+    if (!bytes && source.size() > 0) {
+        copy.resize(source.size());
+        source.read(0, copy.size(), copy.data());
+        bytes = static_cast<const unsigned char*>(copy.data());
+    }
+    const std::uint64_t hash = content_hash(bytes, source.size());
+    const std::string filename = cache_filename(cache_dir, hash);
+
+    Gosu::Bitmap bitmap;
+    if (load_cached_pixels(filename, hash, bitmap)) {
+        ++cache_hits;
+        return bitmap;
+    }
+    ++cache_misses;
+
+    bitmap = Gosu::load_image_file(Gosu::Reader(source, 0));
+    try {
+        save_cached_pixels(filename, hash, bitmap);
+    }
+    catch (const std::exception&) {
+        // A read-only or full disk only costs the next start a decode.
+    }
+    return bitmap;
+}
+
+Gosu::Bitmap load_image_cached(const std::string& filename, const std::string& cache_dir) {
+    return load_image_cached(MappedFile(filename), cache_dir);
+}
+
+ImageCacheStats image_cache_statistics() {
+    ImageCacheStats stats;
+    stats.hits = cache_hits.load();
+    stats.misses = cache_misses.load();
+    return stats;
+}
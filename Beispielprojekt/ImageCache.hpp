@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Gosu/Bitmap.hpp>
+#include <Gosu/IO.hpp>
+#include <cstdint>
+#include <string>
+
+const char* const IMAGE_CACHE_DIR = "image_cache";
+
+// --- Image Cache: decoded bitmaps on disk, keyed by the hash of the encoded file ---
+// The first load of an image decodes it as usual and writes its pixels to
+// <cache_dir>/<hash>.bitmap; every later load of the same bytes maps that file and copies
+// the pixels straight into a Gosu::Bitmap, without decoding anything.
+// Layout (BO_LITTLE header): magic "BMPC", version, width, height, source hash (u64),
+// zero padding up to IMAGE_CACHE_HEADER_SIZE, then width * height pixels in Gosu::Color's
+// memory layout (R, G, B, A bytes, straight alpha), ready for Gosu::Image(const Bitmap&).
+
+// Drop-in replacement for Gosu::load_image_file(filename).
+Gosu::Bitmap load_image_cached(const std::string& filename, const std::string& cache_dir = IMAGE_CACHE_DIR);
+
+// Same for an encoded image in any resource, e.g. an AssetPack entry.
+Gosu::Bitmap load_image_cached(const Gosu::Resource& source, const std::string& cache_dir = IMAGE_CACHE_DIR);
+
+struct ImageCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0; // decoded, and written to the cache if possible
+};
+
+// Totals over all load_image_cached calls of this process.
+ImageCacheStats image_cache_statistics();
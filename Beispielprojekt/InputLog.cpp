@@ -0,0 +1,25 @@
+#include "InputLog.hpp"
+#include <Gosu/IO.hpp>
+#include <stdexcept>
+
+static const std::uint32_t INPUT_LOG_MAGIC = 0x544e5049; // "INPT"
+
+void save_input_log(const std::vector<std::uint8_t>& buttons, const std::string& filename) {
+    Gosu::Buffer buffer;
+    Gosu::Writer writer = buffer.back_writer();
+    writer.write_pod(INPUT_LOG_MAGIC, Gosu::BO_LITTLE);
+    writer.write_pod(static_cast<std::uint32_t>(buttons.size()), Gosu::BO_LITTLE);
+    if (!buttons.empty()) writer.write(buttons.data(), buttons.size());
+    Gosu::save_file(buffer, filename);
+}
+
+std::vector<std::uint8_t> load_input_log(const std::string& filename) {
+    Gosu::File file(filename);
+    Gosu::Reader reader = file.front_reader();
+    if (reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != INPUT_LOG_MAGIC) {
+        throw std::runtime_error("Not an input log: " + filename);
+    }
+    std::vector<std::uint8_t> buttons(reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE));
+    if (!buttons.empty()) reader.read(buttons.data(), buttons.size());
+    return buttons;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --- Input Log: one Buttons byte per tick, enough to re-run a session deterministically ---
+void save_input_log(const std::vector<std::uint8_t>& buttons, const std::string& filename);
+std::vector<std::uint8_t> load_input_log(const std::string& filename);
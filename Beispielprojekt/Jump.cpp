@@ -0,0 +1,230 @@
+#include "Jump.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Drops deeper than this use the reach of this drop, which only underestimates.
+static const int JUMP_TABLE_MAX_DROP = 4096;
+
+namespace {
+    // For every whole-pixel height difference from the highest a jump gets up to
+    // JUMP_TABLE_MAX_DROP below the start: the most ticks a player can be in the air before
+    // their feet come down through that height, or -1.
+    struct JumpTable {
+        int highest = 0; // pixels above the start, as a positive number
+        std::vector<int> ticks;
+        std::vector<int> timing; // second jump that gets there, as in trajectory()
+
+        explicit JumpTable(std::int32_t jumps);
+        std::size_t index(int dy) const {
+            return static_cast<std::size_t>(std::min(dy, JUMP_TABLE_MAX_DROP) + highest);
+        }
+        int at(int dy) const {
+            return dy < -highest ? -1 : ticks[index(dy)];
+        }
+    };
+
+    // Mirrors World::update_players for one player that leaves the ground at tick 0: by
+    // walking off an edge if second_jump is -1, else with a jump, keeping UP held, letting go
+    // one tick before `second_jump` and jumping again then (never, if 0).
+    // Records the feet after every tick, relative to the ground.
+    std::vector<double> trajectory(int second_jump, std::vector<double>& velocities) {
+        std::vector<double> feet;
+        double y = 0, vy = 0;
+        std::int32_t jumps = MAX_JUMPS;
+        bool jump_in_progress = false;
+        for (int t = 0; y <= JUMP_TABLE_MAX_DROP + 1; ++t) {
+            const bool up = second_jump >= 0 &&
+                (t == 0 || (second_jump && t == second_jump) || (second_jump && t < second_jump - 1));
+            const bool jump = up && jumps > 0 && !jump_in_progress;
+            vy = (jump ? JUMP_STRENGTH : vy) + GRAVITY;
+            jumps -= jump;
+            jump_in_progress = up && (jump_in_progress || jump);
+            y += vy;
+            feet.push_back(y);
+            velocities.push_back(vy);
+        }
+        return feet;
+    }
+
+    JumpTable::JumpTable(std::int32_t jumps) {
+        std::vector<int> timings;
+        if (jumps == 0) timings.push_back(-1);
+        else timings.push_back(0);
+        if (jumps >= 2) {
+            // Any tick until the single jump has fallen past the table. Jumping again at the
+            // top gets highest; for deep drops, jumping again just above the target gets farthest.
+            std::vector<double> single_velocities;
+            const int latest = static_cast<int>(trajectory(0, single_velocities).size());
+            for (int second_jump = 2; second_jump <= latest; ++second_jump) timings.push_back(second_jump);
+        }
+
+        std::vector<std::vector<double>> feet, velocities;
+        for (int second_jump : timings) {
+            velocities.emplace_back();
+            feet.push_back(trajectory(second_jump, velocities.back()));
+            highest = std::max(highest, static_cast<int>(std::floor(-*std::min_element(feet.back().begin(), feet.back().end()))));
+        }
+
+        ticks.assign(static_cast<std::size_t>(highest) + JUMP_TABLE_MAX_DROP + 1, -1);
+        timing.assign(ticks.size(), 0);
+        for (std::size_t s = 0; s < feet.size(); ++s) {
+            // Every height is landed on at the first tick that passes it going down; the
+            // longest of those over all jump timings is the reach.
+            std::vector<bool> landed(ticks.size(), false);
+            double before = 0;
+            for (std::size_t t = 0; t < feet[s].size(); ++t) {
+                const double after = feet[s][t];
+                if (velocities[s][t] >= 0) {
+                    const int first = std::max(static_cast<int>(std::ceil(before)), -highest);
+                    const int last = std::min(static_cast<int>(std::floor(after)), JUMP_TABLE_MAX_DROP);
+                    for (int dy = first; dy <= last; ++dy) {
+                        const std::size_t i = static_cast<std::size_t>(dy + highest);
+                        if (landed[i]) continue;
+                        landed[i] = true;
+                        if (static_cast<int>(t) + 1 <= ticks[i]) continue;
+                        ticks[i] = static_cast<int>(t) + 1;
+                        timing[i] = std::max(timings[s], 0);
+                    }
+                }
+                before = after;
+            }
+        }
+    }
+
+    const JumpTable& jump_table(std::int32_t jumps) {
+        static const JumpTable fall(0), single(1), full(MAX_JUMPS);
+        jumps = std::clamp(jumps, 0, MAX_JUMPS);
+        return jumps == 0 ? fall : jumps == 1 ? single : full;
+    }
+}
+
+double jump_height(std::int32_t jumps) {
+    return jump_table(jumps).highest;
+}
+
+double horizontal_reach(double dy, std::int32_t jumps) {
+    const JumpTable& table = jump_table(jumps);
+    // Between two whole pixels, the worse of both.
+    const int above = table.at(static_cast<int>(std::floor(dy)));
+    const int below = table.at(static_cast<int>(std::ceil(dy)));
+    if (above < 0 || below < 0) return -1;
+    return MOVE_SPEED * std::min(above, below);
+}
+
+int second_jump_timing(double dy, std::int32_t jumps) {
+    const JumpTable& table = jump_table(jumps);
+    const int whole = static_cast<int>(std::floor(dy));
+    return table.at(whole) < 0 ? 0 : table.timing[table.index(whole)];
+}
+
+// can_reach without the hazards.
+static bool within_reach(const Surface& from, const Surface& to, std::int32_t jumps) {
+    // The left edges at which a player stands on each surface, as open intervals.
+    const double from_left = from.x - PLAYER_SIZE, from_right = from.x + from.width;
+    const double to_left = to.x - PLAYER_SIZE, to_right = to.x + to.width;
+    const double dy = to.y - from.y;
+    const double gap = std::max(to_left - from_right, from_left - to_right);
+
+    if (gap < 0) {
+        if (dy == 0) return true;
+        // Above: jump straight up through it. Below: step off an edge of `from` over a part
+        // of `to` that sticks out, then fall.
+        if (dy < 0) return horizontal_reach(dy, jumps) >= 0;
+        return to_right - from_right >= 1 || from_left - to_left >= 1;
+    }
+    // Walking moves MOVE_SPEED a tick, so a take-off can be that far short of the edge, and
+    // landing exactly on the open edge of `to` is still a miss.
+    const double reach = horizontal_reach(dy, jumps);
+    return reach >= 0 && gap + MOVE_SPEED < reach;
+}
+
+// Flies a player whose feet leave height y with its left edge at x, steering into
+// [low, high] as PathBot does, with trajectory(second_jump)'s heights: until the feet come
+// down through y + land_dy, or with peak, until the top of the second jump. False if the
+// player touches a hazard on the way, with MOVE_SPEED of room sideways.
+static bool flight_is_clear(double x, double y, double low, double high, int second_jump, double land_dy, bool peak,
+    std::span<const Hazard> hazards) {
+    std::vector<double> velocities;
+    const std::vector<double> feet = trajectory(second_jump, velocities);
+    double before = 0;
+    for (std::size_t t = 0; t < feet.size(); ++t) {
+        if (x + MOVE_SPEED / 2 < low) x += MOVE_SPEED;
+        else if (x - MOVE_SPEED / 2 > high) x -= MOVE_SPEED;
+        // Landed: the player stands on the target at the end of this tick.
+        if (!peak && velocities[t] >= 0 && before <= land_dy && feet[t] >= land_dy) return true;
+        before = feet[t];
+        const double top = y + feet[t] - PLAYER_SIZE;
+        for (const Hazard& hazard : hazards) {
+            if (x < hazard.x + hazard.width + MOVE_SPEED && x + PLAYER_SIZE > hazard.x - MOVE_SPEED &&
+                top < hazard.y + hazard.height && top + PLAYER_SIZE > hazard.y) {
+                return false;
+            }
+        }
+        if (peak && static_cast<int>(t) > second_jump && velocities[t] >= 0) return true;
+    }
+    return true;
+}
+
+// Steering range of a player landing on `to`, with some room to spare, as PathBot steers.
+static void landing_range(const Surface& to, double& low, double& high) {
+    const double to_left = to.x - PLAYER_SIZE, to_right = to.x + to.width;
+    const double margin = std::min(10.0, (to_right - to_left) / 2 - 1);
+    low = to_left + margin;
+    high = std::max(low, to_right - margin);
+}
+
+// Plays the move from `from` to `to` with `jumps` jumps tick by tick, the way PathBot does,
+// until the player lands on `to`. False if the player touches a hazard on the way.
+static bool move_is_clear(const Surface& from, const Surface& to, std::int32_t jumps, std::span<const Hazard> hazards) {
+    const double from_left = from.x - PLAYER_SIZE, from_right = from.x + from.width;
+    const double to_left = to.x - PLAYER_SIZE, to_right = to.x + to.width;
+    const double dy = to.y - from.y;
+    const double gap = std::max(to_left - from_right, from_left - to_right);
+    // Walking from one surface onto the other never leaves them.
+    if (hazards.empty() || (gap < 0 && dy == 0)) return true;
+
+    // Where the player leaves `from`: straight up from under `to`, off the edge `to` sticks
+    // out past, or off the edge facing it.
+    double x;
+    if (gap < 0 && dy < 0) x = (std::max(from_left, to_left) + std::min(from_right, to_right)) / 2;
+    else if (gap < 0) x = to_right - from_right >= 1 ? from_right : from_left;
+    else x = to.x + to.width / 2 < from.x + from.width / 2 ? from_left : from_right;
+    double low, high;
+    landing_range(to, low, high);
+    const int second_jump = jumps == 0 ? -1 : jumps == 1 ? 0 : second_jump_timing(dy, jumps);
+    return flight_is_clear(x, from.y, low, high, second_jump, dy, false, hazards);
+}
+
+bool can_reach(const Surface& from, const Surface& to, std::int32_t jumps, std::span<const Hazard> hazards) {
+    return within_reach(from, to, jumps) && move_is_clear(from, to, jumps, hazards);
+}
+
+bool can_reach_with_temp_platform(const Surface& from, const Surface& to, std::span<const Hazard> hazards) {
+    const double direction = to.x + to.width / 2 < from.x + from.width / 2 ? -1 : 1;
+    // PathBot runs off the edge facing `to` with a double jump towards it, and puts the
+    // platform down at the top of the second jump.
+    if (!hazards.empty()) {
+        double low, high;
+        landing_range(to, low, high);
+        const double edge = direction > 0 ? from.x + from.width : from.x - PLAYER_SIZE;
+        if (!flight_is_clear(edge, from.y, low, high, second_jump_timing(-jump_height()), 0, true, hazards)) return false;
+    }
+    // At the top of a single or double jump, straight up from the edge facing `to` or as far
+    // towards it as the jump gets there. DOWN then puts the platform 2 px under the feet,
+    // centered on the player, who lands on it while standing still.
+    for (std::int32_t jumps = MAX_JUMPS; jumps >= 1; --jumps) {
+        const double rise = jump_height(jumps);
+        const double shift = horizontal_reach(-rise, jumps);
+        if (shift < 0) continue;
+        const double edge = direction > 0 ? from.x + from.width - MOVE_SPEED : from.x - PLAYER_SIZE + MOVE_SPEED;
+        for (double player_x : { edge, edge + direction * shift }) {
+            const Surface platform{ player_x + PLAYER_SIZE / 2 - TEMP_PLATFORM_WIDTH / 2, from.y - rise + 2, TEMP_PLATFORM_WIDTH };
+            // PathBot goes on from the AQUA platform with whichever move it finds first.
+            for (std::int32_t next = 0; next <= MAX_JUMPS; ++next) {
+                if (can_reach(platform, to, next, hazards)) return true;
+            }
+        }
+    }
+    return false;
+}
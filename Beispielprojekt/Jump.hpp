@@ -0,0 +1,44 @@
+#pragma once
+
+#include "World.hpp"
+#include <span>
+
+// --- Jump Reach: where a player can get to from a platform, by World::step's physics ---
+// Derived once from the constants in World.hpp by simulating every timing of the double
+// jump, so it stays right when gravity or jump strength change.
+
+// Top edge of a platform.
+struct Surface {
+    double x, y, width;
+};
+
+// A rectangle a player dies touching, like an Obstacle.
+struct Hazard {
+    double x, y, width, height;
+};
+
+// The jumps below may use up to `jumps` jumps: 0 only walks off an edge, MAX_JUMPS allows
+// a double jump at any timing.
+
+// How far above its start a player's feet get.
+double jump_height(std::int32_t jumps = MAX_JUMPS);
+
+// The farthest a player can move sideways before their feet come down through a height
+// dy below the start (negative: above it), or -1 if the jump never gets there.
+double horizontal_reach(double dy, std::int32_t jumps = MAX_JUMPS);
+
+// When to jump again for that reach, in ticks after taking off (the take-off tick is 0):
+// UP is let go the tick before. 0 if the reach needs no second jump.
+int second_jump_timing(double dy, std::int32_t jumps = MAX_JUMPS);
+
+// Conservative: true only if some input sequence takes a player standing anywhere on
+// `from` to standing on `to`, ignoring everything else in the level but `hazards`. The move
+// as PathBot plays it (take off at the edge facing `to`, or straight up from under it, then
+// steer over it) must not touch those, with MOVE_SPEED of room sideways for where exactly
+// it took off. Hazards on `from` and `to` themselves are the caller's to leave out.
+bool can_reach(const Surface& from, const Surface& to, std::int32_t jumps = MAX_JUMPS,
+    std::span<const Hazard> hazards = {});
+
+// Like can_reach, but with one AQUA platform placed under the player at the top of a jump
+// towards `to`, and a fresh jump from there.
+bool can_reach_with_temp_platform(const Surface& from, const Surface& to, std::span<const Hazard> hazards = {});
@@ -0,0 +1,151 @@
+#include "Level.hpp"
+#include "MappedFile.hpp"
+#include "SpanIO.hpp"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+static const std::uint32_t LEVEL_MAGIC = 0x4c56454c; // "LEVL"
+static const std::uint32_t LEVEL_VERSION = 1;
+
+void LevelData::add_platform(double x, double y, double width, double height) {
+    platform_x.push_back(x);
+    platform_y.push_back(y);
+    platform_width.push_back(width);
+    platform_height.push_back(height);
+}
+
+void LevelData::add_obstacle(double x, double y, double size) {
+    obstacle_x.push_back(x);
+    obstacle_y.push_back(y);
+    obstacle_size.push_back(size);
+}
+
+void LevelData::append(const LevelData& other) {
+    auto extend = [](std::vector<double>& to, const std::vector<double>& from) {
+        to.insert(to.end(), from.begin(), from.end());
+    };
+    extend(platform_x, other.platform_x);
+    extend(platform_y, other.platform_y);
+    extend(platform_width, other.platform_width);
+    extend(platform_height, other.platform_height);
+    extend(obstacle_x, other.obstacle_x);
+    extend(obstacle_y, other.obstacle_y);
+    extend(obstacle_size, other.obstacle_size);
+}
+
+void build_default_level(World& world) {
+    world.clear_level();
+    world.width = 2000;
+    world.height = 1000;
+
+    world.add_platform(0, 950, 2000, 50);
+    world.add_platform(300, 800, 250, 30);
+    world.add_platform(700, 700, 250, 30);
+    world.add_platform(1300, 850, 300, 25);
+    world.add_platform(1700, 600, 200, 30);
+    world.add_platform(1800, 400, 120, 30);
+    world.add_platform(100, 650, 180, 20);
+
+    world.add_obstacle(500, 920, 40);
+    world.add_obstacle(900, 670, 40);
+    world.add_obstacle(1350, 820, 40);
+    world.add_obstacle(1800, 570, 40);
+}
+
+void build_level_geometry(const LevelData& level, LevelGeometry& geometry) {
+    geometry.clear();
+    geometry.platforms.reserve(level.platform_count());
+    for (std::size_t i = 0; i < level.platform_count(); ++i) {
+        geometry.add_platform(level.platform_x[i], level.platform_y[i], level.platform_width[i], level.platform_height[i]);
+    }
+    geometry.obstacles.reserve(level.obstacle_count());
+    for (std::size_t i = 0; i < level.obstacle_count(); ++i) {
+        geometry.add_obstacle(level.obstacle_x[i], level.obstacle_y[i], level.obstacle_size[i]);
+    }
+    geometry.index();
+}
+
+void build_level(World& world, const LevelData& level) {
+    world.clear_level();
+    world.width = level.width;
+    world.height = level.height;
+    build_level_geometry(level, world.geometry);
+}
+
+void save_level(const LevelData& level, const std::string& filename) {
+    Gosu::File file(filename, Gosu::FM_REPLACE);
+    Gosu::Writer writer = file.back_writer();
+    writer.write_pod(LEVEL_MAGIC, Gosu::BO_LITTLE);
+    writer.write_pod(LEVEL_VERSION, Gosu::BO_LITTLE);
+    for (double value : { level.width, level.height, level.spawn_x, level.spawn_y }) {
+        writer.write_pod(value, Gosu::BO_LITTLE);
+    }
+    writer.write_pod(static_cast<std::uint64_t>(level.platform_count()), Gosu::BO_LITTLE);
+    writer.write_pod(static_cast<std::uint64_t>(level.obstacle_count()), Gosu::BO_LITTLE);
+    for (const std::vector<double>* field : { &level.platform_x, &level.platform_y, &level.platform_width,
+        &level.platform_height, &level.obstacle_x, &level.obstacle_y, &level.obstacle_size }) {
+        write_span(writer, std::span<const double>(*field), Gosu::BO_LITTLE);
+    }
+}
+
+LevelData load_level(const std::string& filename) {
+    MappedFile file(filename);
+    return read_level(file, filename);
+}
+
+LevelData read_level(const Gosu::Resource& file, const std::string& filename) {
+    Gosu::Reader reader(file, 0);
+    const std::size_t header_size = 2 * 4 + 4 * 8 + 2 * 8;
+    if (file.size() < header_size || reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != LEVEL_MAGIC ||
+        reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != LEVEL_VERSION) {
+        throw std::runtime_error(filename + " is not a level file");
+    }
+    LevelData level;
+    for (double* value : { &level.width, &level.height, &level.spawn_x, &level.spawn_y }) {
+        *value = reader.get_pod<double>(Gosu::BO_LITTLE);
+    }
+    const std::uint64_t platforms = reader.get_pod<std::uint64_t>(Gosu::BO_LITTLE);
+    const std::uint64_t obstacles = reader.get_pod<std::uint64_t>(Gosu::BO_LITTLE);
+    if (platforms > file.size() / 32 || obstacles > file.size() / 24 ||
+        file.size() - header_size != (platforms * 4 + obstacles * 3) * sizeof(double)) {
+        throw std::runtime_error("Corrupt level file: " + filename);
+    }
+    for (std::vector<double>* field : { &level.platform_x, &level.platform_y, &level.platform_width,
+        &level.platform_height }) {
+        field->resize(static_cast<std::size_t>(platforms));
+        read_span(reader, std::span<double>(*field), Gosu::BO_LITTLE);
+    }
+    for (std::vector<double>* field : { &level.obstacle_x, &level.obstacle_y, &level.obstacle_size }) {
+        field->resize(static_cast<std::size_t>(obstacles));
+        read_span(reader, std::span<double>(*field), Gosu::BO_LITTLE);
+    }
+    return level;
+}
+
+void load_tile_layer(World& world, const std::string& filename) {
+    world.tiles = std::make_unique<TileMap>(load_tile_map(filename));
+    world.width = std::max(world.width, world.tiles->width());
+    world.height = std::max(world.height, world.tiles->height());
+}
+
+void reload_level(World& world, const LevelData& level, LevelGeometry& geometry) {
+    world.geometry.swap(geometry);
+    world.width = level.width;
+    world.height = level.height;
+    if (world.tiles) {
+        world.width = std::max(world.width, world.tiles->width());
+        world.height = std::max(world.height, world.tiles->height());
+    }
+
+    Players& p = world.players;
+    for (std::size_t i = 0; i < p.size(); ++i) {
+        p.spawn_x[i] = level.spawn_x;
+        p.spawn_y[i] = level.spawn_y;
+        bool lost = p.x[i] > world.width - PLAYER_SIZE || p.y[i] > world.height - PLAYER_SIZE;
+        world.geometry.for_each_obstacle_between(p.x[i], p.x[i] + PLAYER_SIZE, [&](const Obstacle& obstacle) {
+            lost = lost || (p.y[i] < obstacle.y + obstacle.height && p.y[i] + PLAYER_SIZE > obstacle.y);
+        });
+        if (lost) p.die(i);
+    }
+}
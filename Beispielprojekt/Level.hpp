@@ -0,0 +1,54 @@
+#pragma once
+
+#include "World.hpp"
+#include <Gosu/IO.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+const double LEVEL_SPAWN_X = 150;
+const double LEVEL_SPAWN_Y = 100;
+
+// --- Level Data: level geometry as flat arrays, the way level files store it ---
+struct LevelData {
+    double width = 0, height = 0;
+    double spawn_x = LEVEL_SPAWN_X, spawn_y = LEVEL_SPAWN_Y;
+    std::vector<double> platform_x, platform_y, platform_width, platform_height;
+    std::vector<double> obstacle_x, obstacle_y, obstacle_size;
+
+    std::size_t platform_count() const { return platform_x.size(); }
+    std::size_t obstacle_count() const { return obstacle_x.size(); }
+
+    void add_platform(double x, double y, double width, double height);
+    void add_obstacle(double x, double y, double size);
+    // Appends the other level's platforms and obstacles; size and spawn stay.
+    void append(const LevelData& other);
+};
+
+// Replaces the world's level geometry with the built-in level and sizes the world to it.
+void build_default_level(World& world);
+
+// Replaces the geometry's platforms and obstacles with the level's and indexes them. Touches
+// no world, so it can run on any thread.
+void build_level_geometry(const LevelData& level, LevelGeometry& geometry);
+
+// Replaces the world's level geometry with the level's and sizes the world to it.
+void build_level(World& world, const LevelData& level);
+
+// Level file, everything BO_LITTLE: magic "LEVL", version, width, height, spawn x and y,
+// platform and obstacle count (u64), then each of the arrays above in that order.
+void save_level(const LevelData& level, const std::string& filename);
+LevelData load_level(const std::string& filename);
+// The same from a level file already in memory; filename is only for error messages.
+LevelData read_level(const Gosu::Resource& file, const std::string& filename);
+
+// Swaps a new level in under running players. geometry must have been built from level by
+// build_level_geometry; it is swapped with the world's, so it holds the old level afterwards.
+// The tile layer stays. Players keep their state unless the new level would put them outside
+// the world or into an obstacle; those go back to the spawn, which becomes the level's for
+// everyone.
+void reload_level(World& world, const LevelData& level, LevelGeometry& geometry);
+
+// Adds a tile layer from a text map (see load_tile_map) to the world's level, growing the
+// world to cover it.
+void load_tile_layer(World& world, const std::string& filename);
@@ -0,0 +1,209 @@
+#include "LevelGen.hpp"
+#include "Jump.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+// Route platforms stay between these heights; spikes only go below SPIKE_BAND_TOP.
+static const double ROUTE_TOP = 300;
+static const double ROUTE_BOTTOM = GENERATED_LEVEL_HEIGHT - 400;
+static const double SPIKE_BAND_TOP = GENERATED_LEVEL_HEIGHT - 250;
+static const double PLATFORM_THICKNESS = 20;
+static const double SPIKE_SIZE = 40;
+static const double ENTRY_WIDTH = 200;
+static const std::size_t CHUNKS_PER_JOB = 64;
+static const int MAX_ROUTE_STEPS = 256;
+static const int TRIES_PER_STEP = 64;
+
+namespace {
+    // splitmix64: one 64-bit state, so every chunk and attempt gets an independent stream.
+    struct Random {
+        std::uint64_t state;
+
+        std::uint64_t next() {
+            std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            return z ^ (z >> 31);
+        }
+        // A whole number of pixels in [low, high].
+        double uniform(double low, double high) {
+            if (high <= low) return low;
+            const std::uint64_t span = static_cast<std::uint64_t>(high - low) + 1;
+            return low + static_cast<double>(next() % span);
+        }
+    };
+
+    std::uint64_t mix(std::uint64_t seed, std::uint64_t a, std::uint64_t b = 0) {
+        Random random{ seed ^ (a * 0xd1b54a32d192ed03) ^ (b * 0x8cb92ba72f3d8dd7) };
+        return random.next();
+    }
+
+    Surface entry(std::uint64_t seed, std::size_t chunk) {
+        Random random{ mix(seed, chunk) };
+        return Surface{ static_cast<double>(chunk) * LEVEL_CHUNK_WIDTH, random.uniform(ROUTE_TOP, ROUTE_BOTTOM), ENTRY_WIDTH };
+    }
+
+    // Breadth-first search over `surfaces` from the first to the last.
+    bool connected(const std::vector<Surface>& surfaces) {
+        std::vector<bool> seen(surfaces.size(), false);
+        std::vector<std::size_t> queue{ 0 };
+        seen[0] = true;
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const Surface& from = surfaces[queue[head]];
+            for (std::size_t i = 0; i < surfaces.size(); ++i) {
+                if (seen[i] || !can_reach(from, surfaces[i])) continue;
+                if (i + 1 == surfaces.size()) return true;
+                seen[i] = true;
+                queue.push_back(i);
+            }
+        }
+        return false;
+    }
+
+    // Lays out the route from `start` into the next chunk's entry (or to the chunk's end, for
+    // the last chunk). Returns false if a step could not be placed.
+    bool lay_route(Random& random, const Surface& start, const Surface* next, double chunk_end,
+        std::vector<Surface>& route) {
+        route.assign(1, start);
+        for (int step = 0; step < MAX_ROUTE_STEPS; ++step) {
+            const Surface& current = route.back();
+            const double right = current.x + current.width;
+            if (next ? right + 400 >= next->x && can_reach(current, *next) : right + 300 >= chunk_end) return true;
+
+            const double goal_y = next ? next->y : current.y;
+            const double remaining = std::max(1.0, (next ? next->x : chunk_end) - right);
+            const double steps_left = std::max(1.0, remaining / 250);
+            bool placed = false;
+            for (int attempt = 0; attempt < TRIES_PER_STEP && !placed; ++attempt) {
+                Surface candidate;
+                candidate.width = random.uniform(80, 240);
+                const double bias = (goal_y - current.y) / steps_left;
+                const double dy = std::clamp(bias + random.uniform(-100, 100), -150.0, 200.0);
+                candidate.y = std::clamp(std::round(current.y + dy), ROUTE_TOP, ROUTE_BOTTOM);
+                const double reach = horizontal_reach(candidate.y - current.y);
+                if (reach < 0) continue;
+                candidate.x = right + PLAYER_SIZE + random.uniform(0, std::max(0.0, 0.8 * reach - 1));
+                // Near the next entry, stay left of it and climb or drop in place if need be.
+                candidate.x = std::min(candidate.x, next ? next->x - PLAYER_SIZE - 10 - candidate.width
+                    : chunk_end - candidate.width);
+                placed = can_reach(current, candidate);
+                if (placed) route.push_back(candidate);
+            }
+            if (!placed) return false;
+        }
+        return false;
+    }
+
+    void generate_chunk(std::uint64_t seed, std::size_t chunk, std::size_t chunks, std::size_t budget,
+        LevelData& level) {
+        const Surface start = entry(seed, chunk);
+        const Surface next = entry(seed, chunk + 1);
+        const bool last = chunk + 1 == chunks;
+        const double chunk_end = start.x + LEVEL_CHUNK_WIDTH;
+
+        std::vector<Surface> route, surfaces;
+        std::vector<double> side_x, side_y, side_width;
+        for (std::uint64_t attempt = 0;; ++attempt) {
+            if (attempt == 1000) throw std::logic_error("Level generator cannot lay out a chunk");
+            Random random{ mix(seed, chunk, attempt + 1) };
+            if (!lay_route(random, start, last ? nullptr : &next, chunk_end, route)) continue;
+
+            const std::size_t rest = budget > route.size() ? budget - route.size() : 0;
+            const std::size_t spikes = rest * 2 / 5, sides = rest - spikes;
+            side_x.clear();
+            side_y.clear();
+            side_width.clear();
+            for (std::size_t i = 0; i < sides; ++i) {
+                // Every other side platform goes into the spike band, to carry spikes.
+                const bool low = i % 2 == 1;
+                side_width.push_back(random.uniform(80, 200));
+                side_x.push_back(random.uniform(start.x, chunk_end - side_width.back()));
+                side_y.push_back(low ? random.uniform(SPIKE_BAND_TOP + SPIKE_SIZE, GENERATED_LEVEL_HEIGHT - 80)
+                    : random.uniform(100, ROUTE_BOTTOM));
+            }
+
+            // Platforms in the spike band are left out: a way through has to avoid them.
+            surfaces = route;
+            for (std::size_t i = 0; i < sides; i += 2) surfaces.push_back(Surface{ side_x[i], side_y[i], side_width[i] });
+            if (!last) surfaces.push_back(next);
+            else surfaces.push_back(route.back());
+            if (!connected(surfaces)) continue;
+
+            for (const Surface& s : route) level.add_platform(s.x, s.y, s.width, PLATFORM_THICKNESS);
+            for (std::size_t i = 0; i < sides; ++i) level.add_platform(side_x[i], side_y[i], side_width[i], PLATFORM_THICKNESS);
+            for (std::size_t i = 0; i < spikes; ++i) {
+                // On the floor, or on one of the low side platforms.
+                const std::size_t carrier = 2 * (i / 2) + 1;
+                if (i % 2 == 0 || carrier >= sides) {
+                    level.add_obstacle(random.uniform(start.x, chunk_end - SPIKE_SIZE), GENERATED_LEVEL_HEIGHT - SPIKE_SIZE, SPIKE_SIZE);
+                    continue;
+                }
+                const double x = random.uniform(side_x[carrier], side_x[carrier] + side_width[carrier] - SPIKE_SIZE);
+                level.add_obstacle(x, side_y[carrier] - SPIKE_SIZE, SPIKE_SIZE);
+            }
+            return;
+        }
+    }
+}
+
+LevelData generate_level(std::uint64_t seed, std::size_t objects, unsigned threads) {
+    const std::size_t chunks = std::max<std::size_t>(1, (objects + LEVEL_CHUNK_OBJECTS - 1) / LEVEL_CHUNK_OBJECTS);
+    const std::size_t jobs = (chunks + CHUNKS_PER_JOB - 1) / CHUNKS_PER_JOB;
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // One part per job, joined in chunk order afterwards, so the threads never share a vector.
+    std::vector<LevelData> parts(jobs);
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+    auto work = [&] {
+        while (!failed) {
+            const std::size_t job = next++;
+            if (job >= jobs) return;
+            try {
+                const std::size_t end = std::min(chunks, (job + 1) * CHUNKS_PER_JOB);
+                for (std::size_t chunk = job * CHUNKS_PER_JOB; chunk < end; ++chunk) {
+                    const std::size_t budget = chunk + 1 < chunks ? LEVEL_CHUNK_OBJECTS
+                        : objects - std::min(objects, chunk * LEVEL_CHUNK_OBJECTS);
+                    generate_chunk(seed, chunk, chunks, budget, parts[job]);
+                }
+            }
+            catch (...) {
+                if (!failed.exchange(true)) error = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < std::min<std::size_t>(threads, jobs); ++t) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+    if (error) std::rethrow_exception(error);
+
+    LevelData level;
+    level.width = static_cast<double>(chunks) * LEVEL_CHUNK_WIDTH;
+    level.height = GENERATED_LEVEL_HEIGHT;
+    const Surface start = entry(seed, 0);
+    level.spawn_x = start.x + (start.width - PLAYER_SIZE) / 2;
+    level.spawn_y = start.y - PLAYER_SIZE;
+
+    std::size_t platforms = 0, obstacles = 0;
+    for (const LevelData& part : parts) {
+        platforms += part.platform_count();
+        obstacles += part.obstacle_count();
+    }
+    for (std::vector<double>* field : { &level.platform_x, &level.platform_y, &level.platform_width, &level.platform_height }) {
+        field->reserve(platforms);
+    }
+    for (std::vector<double>* field : { &level.obstacle_x, &level.obstacle_y, &level.obstacle_size }) {
+        field->reserve(obstacles);
+    }
+    for (LevelData& part : parts) {
+        level.append(part);
+        part = LevelData();
+    }
+    return level;
+}
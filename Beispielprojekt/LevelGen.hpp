@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Level.hpp"
+#include <cstddef>
+#include <cstdint>
+
+const double LEVEL_CHUNK_WIDTH = 4096;
+const double GENERATED_LEVEL_HEIGHT = 1600;
+const std::size_t LEVEL_CHUNK_OBJECTS = 64;
+
+// --- Level Generator: seeded random levels of any length ---
+// The level is a row of LEVEL_CHUNK_WIDTH wide chunks. Each chunk starts with an entry
+// platform whose height only depends on the seed and the chunk's number, so every chunk can
+// be generated on its own, on any thread, and still lead into the next one. Inside a chunk a
+// route of platforms is laid out step by step, each one within jump reach (see Jump.hpp) of
+// the one before, bending towards the next chunk's entry. The rest of the chunk's objects are
+// side platforms and spikes; spikes are kept in a band below the route, where nobody on the
+// route ever gets to. Before a chunk is accepted, a search over all of its platforms must get
+// from the entry to the next entry; otherwise it is generated again from a derived seed.
+// The same seed and object count always give the same level, whatever the thread count.
+
+// Generates a level with about `objects` platforms and spikes (never fewer), from
+// LEVEL_CHUNK_OBJECTS per chunk. threads = 0 uses every hardware thread.
+LevelData generate_level(std::uint64_t seed, std::size_t objects, unsigned threads = 0);
@@ -0,0 +1,165 @@
+#include "LevelWatcher.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// The watch thread checks for shutdown at least this often.
+static const int LEVEL_WATCH_POLL_MS = 100;
+
+struct LevelWatcher::Impl {
+#ifdef _WIN32
+    // Windows only says that something in the directory changed; the file's time and size
+    // tell whether it was this file.
+    HANDLE change = INVALID_HANDLE_VALUE;
+    std::filesystem::path path;
+    std::filesystem::file_time_type last_write;
+    std::uintmax_t last_size = 0;
+#else
+    int fd = -1;
+    std::string name;
+#endif
+
+    ~Impl() {
+#ifdef _WIN32
+        if (change != INVALID_HANDLE_VALUE) FindCloseChangeNotification(change);
+#else
+        if (fd != -1) close(fd);
+#endif
+    }
+
+    // Waits up to timeout_ms for a change to the directory. Returns true if the file may have
+    // been written, created or replaced meanwhile.
+    bool wait(int timeout_ms) {
+#ifdef _WIN32
+        if (WaitForSingleObject(change, static_cast<DWORD>(timeout_ms)) != WAIT_OBJECT_0) return false;
+        FindNextChangeNotification(change);
+        std::error_code time_error, size_error;
+        const auto write = std::filesystem::last_write_time(path, time_error);
+        const std::uintmax_t size = std::filesystem::file_size(path, size_error);
+        if (time_error || size_error || (write == last_write && size == last_size)) return false;
+        last_write = write;
+        last_size = size;
+        return true;
+#else
+        pollfd ready{ fd, POLLIN, 0 };
+        if (poll(&ready, 1, timeout_ms) <= 0) return false;
+        alignas(inotify_event) char buffer[4096];
+        bool changed = false;
+        for (;;) {
+            const ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length <= 0) break;
+            for (const char* at = buffer; at < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+                changed = changed || (event->len && name == event->name);
+                at += sizeof(inotify_event) + event->len;
+            }
+        }
+        return changed;
+#endif
+    }
+};
+
+LevelWatcher::LevelWatcher(const std::string& filename)
+    : pimpl(new Impl), filename(filename) {
+    const std::filesystem::path path(filename);
+    const std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+#ifdef _WIN32
+    pimpl->change = FindFirstChangeNotificationW(directory.c_str(), FALSE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (pimpl->change == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot watch " + directory.string());
+    std::error_code ignored;
+    pimpl->path = path;
+    pimpl->last_write = std::filesystem::last_write_time(path, ignored);
+    pimpl->last_size = std::filesystem::file_size(path, ignored);
+#else
+    pimpl->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    pimpl->name = path.filename().string();
+    if (pimpl->fd == -1 || inotify_add_watch(pimpl->fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) == -1) {
+        throw std::runtime_error("Cannot watch " + directory.string());
+    }
+#endif
+    thread = std::thread(&LevelWatcher::run, this);
+}
+
+LevelWatcher::~LevelWatcher() {
+    stopping = true;
+    thread.join();
+}
+
+std::unique_ptr<LoadedLevel> LevelWatcher::take() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::move(pending);
+}
+
+void LevelWatcher::retire(std::unique_ptr<LoadedLevel> level) {
+    std::lock_guard<std::mutex> lock(mutex);
+    retired.push_back(std::move(level));
+}
+
+std::string LevelWatcher::take_error() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string message;
+    message.swap(error);
+    return message;
+}
+
+void LevelWatcher::reload() {
+    try {
+        // A copy rather than a mapping: the file may be written again while it is parsed.
+        Gosu::Buffer data;
+        Gosu::load_file(data, filename);
+        auto level = std::make_unique<LoadedLevel>();
+        level->data = read_level(data, filename);
+        build_level_geometry(level->data, level->geometry);
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = std::move(level);
+        error.clear();
+    }
+    catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = e.what();
+    }
+}
+
+void LevelWatcher::run() {
+    using Clock = std::chrono::steady_clock;
+    const auto settle = std::chrono::milliseconds(LEVEL_WATCH_SETTLE_MS);
+    bool changed = false;
+    Clock::time_point last_change;
+    while (!stopping) {
+        {
+            // Freed outside the lock, so take() and retire() never wait for it.
+            std::vector<std::unique_ptr<LoadedLevel>> old;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                old.swap(retired);
+            }
+        }
+        int timeout = LEVEL_WATCH_POLL_MS;
+        if (changed) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(last_change + settle - Clock::now());
+            timeout = std::clamp(static_cast<int>(left.count()), 0, LEVEL_WATCH_POLL_MS);
+        }
+        if (pimpl->wait(timeout)) {
+            changed = true;
+            last_change = Clock::now();
+        }
+        else if (changed && Clock::now() - last_change >= settle) {
+            changed = false;
+            reload();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Level.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// How long a changed level file must stay untouched before it is read, so a save that takes
+// several writes is read once, at its end.
+const int LEVEL_WATCH_SETTLE_MS = 50;
+
+// --- Loaded Level: a level file parsed and its geometry built, ready for reload_level ---
+struct LoadedLevel {
+    LevelData data;
+    LevelGeometry geometry;
+};
+
+// --- Level Watcher: loads a level file again in the background whenever it changes ---
+// A thread watches the file's directory (inotify on Linux, a change notification on Windows),
+// so editors that save by writing a new file and renaming it over the old one are seen too.
+// Once the file has been quiet for LEVEL_WATCH_SETTLE_MS it is read into memory, parsed, and
+// its platforms and obstacles are built and indexed, all on that thread. The result waits for
+// the game to take() it at a frame boundary. reload_level then only swaps the geometry in and
+// checks the players, and the old geometry goes back through retire() to be freed here too.
+class LevelWatcher {
+    struct Impl;
+    const std::unique_ptr<Impl> pimpl;
+
+    std::string filename;
+    std::mutex mutex;
+    std::unique_ptr<LoadedLevel> pending;
+    std::vector<std::unique_ptr<LoadedLevel>> retired;
+    std::string error;
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+
+    void reload();
+    void run();
+
+public:
+    // Throws if the directory cannot be watched.
+    explicit LevelWatcher(const std::string& filename);
+    ~LevelWatcher();
+    LevelWatcher(const LevelWatcher&) = delete;
+    LevelWatcher& operator=(const LevelWatcher&) = delete;
+
+    // The newest level loaded since the last call, or null. Never blocks on loading.
+    std::unique_ptr<LoadedLevel> take();
+    // Hands a level back after reload_level, which left the old geometry in it, so that is
+    // freed on the watch thread as well.
+    void retire(std::unique_ptr<LoadedLevel> level);
+    // Why the last reload failed, or empty; the old level stays meanwhile.
+    std::string take_error();
+};
@@ -0,0 +1,95 @@
+#include "MappedFile.hpp"
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct MappedFile::Impl {
+    const void* data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    ~Impl() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (data) munmap(const_cast<void*>(data), size);
+        if (fd != -1) close(fd);
+#endif
+    }
+};
+
+MappedFile::MappedFile(const std::string& filename)
+    : pimpl(new Impl) {
+#ifdef _WIN32
+    int length = MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, nullptr, 0);
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, &wide[0], length);
+
+    pimpl->file = CreateFileW(wide.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (pimpl->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(pimpl->file, &size)) {
+        throw std::runtime_error("Could not open " + filename);
+    }
+    pimpl->size = static_cast<std::size_t>(size.QuadPart);
+    if (pimpl->size == 0) return;
+
+    pimpl->mapping = CreateFileMappingW(pimpl->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (pimpl->mapping) pimpl->data = MapViewOfFile(pimpl->mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    pimpl->fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (pimpl->fd == -1 || fstat(pimpl->fd, &info) != 0) {
+        throw std::runtime_error("Could not open " + filename);
+    }
+    pimpl->size = static_cast<std::size_t>(info.st_size);
+    if (pimpl->size == 0) return;
+
+    void* data = mmap(nullptr, pimpl->size, PROT_READ, MAP_SHARED, pimpl->fd, 0);
+    if (data != MAP_FAILED) pimpl->data = data;
+#endif
+    if (!pimpl->data) throw std::runtime_error("Could not map " + filename);
+}
+
+MappedFile::~MappedFile() = default;
+
+std::size_t MappedFile::size() const {
+    return pimpl->size;
+}
+
+void MappedFile::resize(std::size_t) {
+    throw std::logic_error("MappedFile is read-only");
+}
+
+void MappedFile::read(std::size_t offset, std::size_t length, void* dest_buffer) const {
+    if (offset > pimpl->size || length > pimpl->size - offset) {
+        throw std::length_error("Read past the end of a mapped file");
+    }
+    if (length) std::memcpy(dest_buffer, static_cast<const char*>(pimpl->data) + offset, length);
+}
+
+void MappedFile::write(std::size_t, std::size_t, const void*) {
+    throw std::logic_error("MappedFile is read-only");
+}
+
+const void* MappedFile::data() const {
+    return pimpl->data;
+}
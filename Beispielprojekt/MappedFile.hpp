@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Gosu/IO.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// --- Mapped File: a read-only file with the Gosu::Resource interface, memory-mapped ---
+// Unlike Gosu::load_file, opening does not copy anything: data() points straight into the
+// page cache, and pages are only read from disk when they are first touched.
+class MappedFile : public Gosu::Resource {
+    struct Impl;
+    const std::unique_ptr<Impl> pimpl;
+
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    std::size_t size() const override;
+
+    // Mapped files are read-only; resize and write throw std::logic_error.
+    void resize(std::size_t new_size) override;
+
+    void read(std::size_t offset, std::size_t length, void* dest_buffer) const override;
+
+    void write(std::size_t offset, std::size_t length, const void* source_buffer) override;
+
+    // Like Gosu::Buffer::data(). nullptr for an empty file.
+    const void* data() const;
+};
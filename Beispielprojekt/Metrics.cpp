@@ -0,0 +1,224 @@
+#include "Metrics.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static const std::uint32_t METRICS_MAGIC = 0x4352544d; // "MTRC"
+static const std::uint32_t METRICS_VERSION = 1;
+static const int METRICS_READ_ATTEMPTS = 100;
+static const int METRICS_SILENCE_LIMIT = 5;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+    "The sequence number is shared between processes, so it must not need a lock");
+
+struct MetricsBlock {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::atomic<std::uint64_t> sequence;
+    MetricsSnapshot snapshot;
+};
+
+void MetricsSnapshot::add_frame(std::uint64_t frame_ns) {
+    ++frames;
+    std::uint64_t bucket = frame_ns / 1000000;
+    ++frame_histogram[bucket < METRICS_FRAME_BUCKETS ? bucket : METRICS_FRAME_BUCKETS - 1];
+}
+
+std::uint64_t resident_memory_bytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof counters)) return 0;
+    return counters.WorkingSetSize;
+#else
+    // Second field of /proc/self/statm: resident pages (Linux only; 0 elsewhere).
+    std::ifstream statm("/proc/self/statm");
+    std::uint64_t total = 0, resident = 0;
+    if (!(statm >> total >> resident)) return 0;
+    return resident * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// --- Shared Segment: the mapped MetricsBlock, created by the publisher, opened by readers ---
+
+struct SharedSegment {
+    MetricsBlock* block = nullptr;
+    std::string name;
+    bool owner;
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    SharedSegment(const std::string& segment_name, bool create)
+        : owner(create) {
+        void* memory = nullptr;
+#ifdef _WIN32
+        name = "Local\\" + segment_name;
+        std::wstring wide(name.begin(), name.end());
+        mapping = create
+            ? CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                static_cast<DWORD>(sizeof(MetricsBlock)), wide.c_str())
+            : OpenFileMappingW(FILE_MAP_READ, FALSE, wide.c_str());
+        if (mapping) {
+            memory = MapViewOfFile(mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0,
+                sizeof(MetricsBlock));
+        }
+#else
+        name = "/" + segment_name;
+        fd = shm_open(name.c_str(), create ? O_CREAT | O_RDWR : O_RDONLY, 0644);
+        if (fd != -1 && (!create || ftruncate(fd, sizeof(MetricsBlock)) == 0)) {
+            memory = mmap(nullptr, sizeof(MetricsBlock), create ? PROT_READ | PROT_WRITE : PROT_READ,
+                MAP_SHARED, fd, 0);
+            if (memory == MAP_FAILED) memory = nullptr;
+        }
+#endif
+        if (!memory) {
+            release();
+            throw std::runtime_error(
+                (create ? "Could not create " : "No metrics published as ") + segment_name);
+        }
+        block = static_cast<MetricsBlock*>(memory);
+    }
+
+    ~SharedSegment() {
+        release();
+    }
+
+    void release() {
+#ifdef _WIN32
+        if (block) UnmapViewOfFile(block);
+        if (mapping) CloseHandle(mapping);
+#else
+        if (block) munmap(block, sizeof(MetricsBlock));
+        if (fd != -1) close(fd);
+        if (owner && fd != -1) shm_unlink(name.c_str());
+#endif
+        block = nullptr;
+    }
+};
+
+// --- Metrics Publisher ---
+
+struct MetricsPublisher::Impl : SharedSegment {
+    using SharedSegment::SharedSegment;
+};
+
+MetricsPublisher::MetricsPublisher(const std::string& name)
+    : pimpl(new Impl(name, true)) {
+    MetricsBlock* block = new (pimpl->block) MetricsBlock();
+    block->magic = METRICS_MAGIC;
+    block->version = METRICS_VERSION;
+}
+
+MetricsPublisher::~MetricsPublisher() {
+    MetricsSnapshot last = pimpl->block->snapshot;
+    last.closed = 1;
+    publish(last);
+}
+
+void MetricsPublisher::publish(const MetricsSnapshot& snapshot) {
+    MetricsBlock& block = *pimpl->block;
+    const std::uint64_t sequence = block.sequence.load(std::memory_order_relaxed);
+    block.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&block.snapshot, &snapshot, sizeof snapshot);
+    block.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// --- Metrics Reader ---
+
+struct MetricsReader::Impl : SharedSegment {
+    using SharedSegment::SharedSegment;
+};
+
+MetricsReader::MetricsReader(const std::string& name)
+    : pimpl(new Impl(name, false)) {
+    if (pimpl->block->magic != METRICS_MAGIC || pimpl->block->version != METRICS_VERSION) {
+        throw std::runtime_error("Metrics segment " + name + " has an unknown format");
+    }
+}
+
+MetricsReader::~MetricsReader() = default;
+
+bool MetricsReader::read(MetricsSnapshot& snapshot) const {
+    const MetricsBlock& block = *pimpl->block;
+    for (int attempt = 0; attempt < METRICS_READ_ATTEMPTS; ++attempt) {
+        const std::uint64_t before = block.sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        std::memcpy(&snapshot, &block.snapshot, sizeof snapshot);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block.sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+int run_metrics_reader() {
+    std::unique_ptr<MetricsReader> opened;
+    try {
+        opened = std::make_unique<MetricsReader>();
+    }
+    catch (const std::exception& e) {
+        std::printf("%s; is the game running?\n", e.what());
+        return 1;
+    }
+    const MetricsReader& reader = *opened;
+    MetricsSnapshot last, now;
+    while (!reader.read(last)) {}
+    int silent_seconds = 0;
+
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (!reader.read(now)) continue;
+        if (now.closed) {
+            std::printf("Game closed after %llu ticks\n", static_cast<unsigned long long>(now.ticks));
+            return 0;
+        }
+        const double seconds = (now.published_ns - last.published_ns) * 1e-9;
+        if (seconds <= 0) {
+            // A game that crashed never marks the segment closed.
+            if (++silent_seconds >= METRICS_SILENCE_LIMIT) {
+                std::printf("No new metrics for %d seconds, giving up\n", silent_seconds);
+                return 1;
+            }
+            continue;
+        }
+        silent_seconds = 0;
+
+        std::printf("tick %llu  %.1f steps/s  %.1f FPS  frame p50 %.2f p99 %.2f ms  "
+            "update p99 %.3f ms  draw p99 %.3f ms  %u draw ops  image cache %llu/%llu hits  %.1f MiB\n",
+            static_cast<unsigned long long>(now.ticks), (now.ticks - last.ticks) / seconds,
+            (now.frames - last.frames) / seconds, now.frame_ms.p50, now.frame_ms.p99,
+            now.update_ms.p99, now.draw_ms.p99, now.draw_ops,
+            static_cast<unsigned long long>(now.image_cache_hits),
+            static_cast<unsigned long long>(now.image_cache_hits + now.image_cache_misses),
+            now.resident_bytes / (1024.0 * 1024.0));
+        std::printf("  frames:");
+        for (std::size_t i = 0; i < METRICS_FRAME_BUCKETS; ++i) {
+            std::uint64_t count = now.frame_histogram[i] - last.frame_histogram[i];
+            if (count) std::printf(" %zu%s ms x%llu", i, i + 1 == METRICS_FRAME_BUCKETS ? "+" : "",
+                static_cast<unsigned long long>(count));
+        }
+        std::printf("\n");
+        last = now;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "FrameTiming.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+const char* const METRICS_SEGMENT_NAME = "beispielprojekt_metrics";
+// Bucket i counts frames that took i to i + 1 ms; the last one everything longer.
+const std::size_t METRICS_FRAME_BUCKETS = 64;
+
+// Plain data, copied as a whole into and out of shared memory. Counters only grow, so a
+// reader derives rates (steps/s, cache hits/s) from two snapshots.
+struct MetricsSnapshot {
+    std::uint64_t published_ns = 0; // nanoseconds() of the publishing process
+    std::uint64_t ticks = 0;
+    std::uint64_t frames = 0;
+    std::uint64_t image_cache_hits = 0, image_cache_misses = 0;
+    std::uint64_t resident_bytes = 0;
+    std::uint32_t draw_ops = 0;
+    std::uint32_t closed = 0; // set by the publisher's destructor
+    TimingPercentiles update_ms, draw_ms, frame_ms;
+    std::uint64_t frame_histogram[METRICS_FRAME_BUCKETS] = {};
+
+    void add_frame(std::uint64_t frame_ns);
+};
+
+// Memory the process currently occupies in RAM (working set / resident set size).
+std::uint64_t resident_memory_bytes();
+
+// --- Metrics Publisher / Reader: live counters in a named shared memory segment ---
+// Purely local: another process on the same machine maps the segment and reads it, no
+// sockets involved. The single writer updates it under a seqlock: the sequence number is
+// odd while a write is in progress, and a reader retries whenever it saw an odd number or
+// the number changed during its copy. The writer never waits for readers.
+class MetricsPublisher {
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+
+public:
+    explicit MetricsPublisher(const std::string& name = METRICS_SEGMENT_NAME);
+    ~MetricsPublisher();
+
+    void publish(const MetricsSnapshot& snapshot);
+};
+
+class MetricsReader {
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+
+public:
+    // Throws std::runtime_error if no process publishes under this name.
+    explicit MetricsReader(const std::string& name = METRICS_SEGMENT_NAME);
+    ~MetricsReader();
+
+    // Returns false if the writer kept overwriting the snapshot while it was copied.
+    bool read(MetricsSnapshot& snapshot) const;
+};
+
+// Prints the metrics of a running game once per second until it closes.
+int run_metrics_reader();
@@ -0,0 +1,390 @@
+#include "NavGraph.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+// Farthest sideways any edge can go: a jump to an AQUA platform, then the longest drop.
+static double nav_range() {
+    static const double range = jump_height() + 2 * horizontal_reach(1e6) + TEMP_PLATFORM_WIDTH + PLAYER_SIZE;
+    return range;
+}
+
+static double center(const Surface& s) {
+    return s.x + s.width / 2;
+}
+
+bool find_move(const Surface& from, const Surface& to, bool use_temp_platforms, std::span<const Hazard> hazards,
+    NavEdgeKind& kind, double& ticks) {
+    const double dy = to.y - from.y;
+    if (can_reach(from, to, 0, hazards)) {
+        kind = dy == 0 ? NAV_WALK : NAV_FALL;
+        ticks = dy == 0 ? 0 : horizontal_reach(dy, 0) / MOVE_SPEED;
+    }
+    else if (can_reach(from, to, 1, hazards)) {
+        kind = NAV_JUMP;
+        ticks = horizontal_reach(dy, 1) / MOVE_SPEED;
+    }
+    else if (can_reach(from, to, MAX_JUMPS, hazards)) {
+        kind = NAV_DOUBLE_JUMP;
+        ticks = horizontal_reach(dy, MAX_JUMPS) / MOVE_SPEED;
+    }
+    else if (use_temp_platforms && can_reach_with_temp_platform(from, to, hazards)) {
+        // Two jumps, plus the cooldown before the next AQUA platform.
+        kind = NAV_TEMP_PLATFORM;
+        ticks = horizontal_reach(-jump_height()) / MOVE_SPEED +
+            std::max(0.0, horizontal_reach(dy + jump_height())) / MOVE_SPEED + PLATFORM_COOLDOWN;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+std::size_t NavGraph::chunk_of(double x) const {
+    return x <= 0 ? 0 : static_cast<std::size_t>(x / LEVEL_CHUNK_WIDTH);
+}
+
+std::uint32_t NavGraph::add_node(const Surface& surface) {
+    std::uint32_t id;
+    if (free_ids.empty()) {
+        id = static_cast<std::uint32_t>(surfaces.size());
+        surfaces.push_back(surface);
+        node_chunk.push_back(0);
+        node_index.push_back(0);
+    }
+    else {
+        id = free_ids.back();
+        free_ids.pop_back();
+        surfaces[id] = surface;
+    }
+    const std::size_t c = chunk_of(surface.x);
+    if (c >= chunks.size()) chunks.resize(c + 1);
+    node_chunk[id] = static_cast<std::uint32_t>(c);
+    chunks[c].nodes.push_back(id);
+    widest = std::max(widest, surface.width);
+    return id;
+}
+
+void NavGraph::sort_chunk(std::size_t c) {
+    std::vector<std::uint32_t>& nodes = chunks[c].nodes;
+    std::sort(nodes.begin(), nodes.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return surfaces[a].x < surfaces[b].x || (surfaces[a].x == surfaces[b].x && a < b);
+    });
+    for (std::size_t i = 0; i < nodes.size(); ++i) node_index[nodes[i]] = static_cast<std::uint32_t>(i);
+}
+
+void NavGraph::link_chunk(std::size_t c) {
+    Chunk& chunk = chunks[c];
+    chunk.edge_begin.assign(1, 0);
+    chunk.edges.clear();
+    chunk.neighbours.clear();
+    const double range = nav_range();
+
+    for (std::uint32_t a : chunk.nodes) {
+        const Surface& from = surfaces[a];
+        const std::span<const Hazard> near = hazards_near(from);
+        const double left = from.x - PLAYER_SIZE - range, right = from.x + from.width + range;
+        const std::size_t last = std::min(chunk_of(right), chunks.size() - 1);
+        for (std::size_t d = chunk_of(left - widest); d <= last; ++d) {
+            for (std::uint32_t b : chunks[d].nodes) {
+                const Surface& to = surfaces[b];
+                if (to.x - PLAYER_SIZE > right) break;
+                if (b == a || to.x + to.width < left) continue;
+
+                NavEdgeKind kind;
+                double ticks;
+                if (!find_move(from, to, use_temp_platforms, near, kind, ticks)) continue;
+                // Never below the straight walk between the centers, so A*'s estimate holds.
+                const double cost = std::max(ticks, std::abs(center(to) - center(from)) / MOVE_SPEED);
+                chunk.edges.push_back(NavEdge{ b, kind, static_cast<float>(cost) });
+                if (d != c) chunk.neighbours.push_back(static_cast<std::uint32_t>(d));
+            }
+        }
+        chunk.edge_begin.push_back(static_cast<std::uint32_t>(chunk.edges.size()));
+    }
+    std::sort(chunk.neighbours.begin(), chunk.neighbours.end());
+    chunk.neighbours.erase(std::unique(chunk.neighbours.begin(), chunk.neighbours.end()), chunk.neighbours.end());
+}
+
+void NavGraph::build(std::span<const Surface> level, std::span<const Hazard> obstacles, unsigned threads) {
+    chunks.clear();
+    surfaces.clear();
+    node_chunk.clear();
+    node_index.clear();
+    free_ids.clear();
+    widest = 0;
+    reach_cache.clear();
+
+    hazards.assign(obstacles.begin(), obstacles.end());
+    std::sort(hazards.begin(), hazards.end(), [](const Hazard& a, const Hazard& b) { return a.x < b.x; });
+    widest_hazard = 0;
+    for (const Hazard& hazard : hazards) widest_hazard = std::max(widest_hazard, hazard.width);
+
+    surfaces.reserve(level.size());
+    for (const Surface& surface : level) add_node(surface);
+    for (std::size_t c = 0; c < chunks.size(); ++c) sort_chunk(c);
+
+    // Chunks only write their own edges, so they can be linked in any order.
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+        for (std::size_t c = next++; c < chunks.size(); c = next++) link_chunk(c);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < std::min<std::size_t>(threads, chunks.size()); ++t) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void NavGraph::update_chunk(std::size_t c, std::span<const Surface> level) {
+    for (const Surface& surface : level) {
+        if (chunk_of(surface.x) != c) throw std::invalid_argument("Surface is not in the chunk it is added to");
+    }
+    if (c >= chunks.size()) chunks.resize(c + 1);
+    for (std::uint32_t id : chunks[c].nodes) {
+        node_chunk[id] = NAV_NO_NODE;
+        free_ids.push_back(id);
+    }
+    chunks[c].nodes.clear();
+    for (const Surface& surface : level) add_node(surface);
+    sort_chunk(c);
+
+    // Every chunk with a node that may have an edge into this one; see link_chunk.
+    const double range = nav_range();
+    const double chunk_left = static_cast<double>(c) * LEVEL_CHUNK_WIDTH;
+    const std::size_t first = chunk_of(chunk_left - widest - range);
+    const std::size_t last = std::min(chunk_of(chunk_left + LEVEL_CHUNK_WIDTH + PLAYER_SIZE + range + widest),
+        chunks.size() - 1);
+    for (std::size_t d = first; d <= last; ++d) link_chunk(d);
+    reach_cache.clear();
+}
+
+std::size_t NavGraph::edge_count() const {
+    std::size_t count = 0;
+    for (const Chunk& chunk : chunks) count += chunk.edges.size();
+    return count;
+}
+
+std::span<const NavEdge> NavGraph::edges(std::uint32_t node) const {
+    const Chunk& chunk = chunks[node_chunk[node]];
+    const std::uint32_t i = node_index[node];
+    return std::span<const NavEdge>(chunk.edges.data() + chunk.edge_begin[i], chunk.edge_begin[i + 1] - chunk.edge_begin[i]);
+}
+
+std::span<const std::uint32_t> NavGraph::chunk_nodes(std::size_t c) const {
+    if (c >= chunks.size()) return {};
+    return chunks[c].nodes;
+}
+
+std::span<const Hazard> NavGraph::hazards_near(const Surface& from) const {
+    // Anything starting further left than this ends before any move from `from` gets there;
+    // the player may pass MOVE_SPEED closer than can_reach's plan, see there.
+    const double range = nav_range() + PLAYER_SIZE + MOVE_SPEED;
+    auto by_x = [](const Hazard& hazard, double x) { return hazard.x < x; };
+    auto first = std::lower_bound(hazards.begin(), hazards.end(), from.x - range - widest_hazard, by_x);
+    auto last = std::lower_bound(first, hazards.end(), from.x + from.width + range, by_x);
+    return std::span<const Hazard>(hazards).subspan(first - hazards.begin(), last - first);
+}
+
+std::uint32_t NavGraph::node_under(double player_x, double player_y) const {
+    if (chunks.empty()) return NAV_NO_NODE;
+    const double feet = player_y + PLAYER_SIZE;
+    const std::size_t last = std::min(chunk_of(player_x + PLAYER_SIZE), chunks.size() - 1);
+    for (std::size_t c = chunk_of(player_x - widest); c <= last; ++c) {
+        for (std::uint32_t id : chunks[c].nodes) {
+            const Surface& s = surfaces[id];
+            if (s.x >= player_x + PLAYER_SIZE) break;
+            if (player_x < s.x + s.width && std::abs(feet - s.y) < 0.5) return id;
+        }
+    }
+    return NAV_NO_NODE;
+}
+
+std::uint32_t NavGraph::entry_node(const Surface& from, double player_x, std::uint32_t to) {
+    if (chunks.empty()) return NAV_NO_NODE;
+    // Nearest first, so the path search only runs until one works out.
+    std::vector<std::pair<double, std::uint32_t>> candidates;
+    const std::span<const Hazard> near = hazards_near(from);
+    const double range = nav_range();
+    const double left = std::max(from.x, player_x - range) - PLAYER_SIZE - range;
+    const double right = std::min(from.x + from.width, player_x + PLAYER_SIZE + range) + range;
+    const std::size_t last = std::min(chunk_of(right), chunks.size() - 1);
+    for (std::size_t c = chunk_of(left - widest); c <= last; ++c) {
+        for (std::uint32_t id : chunks[c].nodes) {
+            const Surface& s = surfaces[id];
+            if (s.x - PLAYER_SIZE > right) break;
+            NavEdgeKind kind;
+            double ticks;
+            if (s.x + s.width < left || !find_move(from, s, use_temp_platforms, near, kind, ticks)) continue;
+            candidates.emplace_back(std::abs(center(s) - (player_x + PLAYER_SIZE / 2)), id);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (const auto& [distance, id] : candidates) {
+        if (reachable(id, to)) return id;
+    }
+    return NAV_NO_NODE;
+}
+
+void NavGraph::next_stamp() {
+    stamp.resize(surfaces.size(), 0);
+    came_from.resize(surfaces.size());
+    cost_so_far.resize(surfaces.size());
+    chunk_visited.resize(chunks.size(), 0);
+    chunk_in_corridor.resize(chunks.size(), 0);
+    chunk_came_from.resize(chunks.size());
+    if (++search_stamp == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        std::fill(chunk_visited.begin(), chunk_visited.end(), 0);
+        std::fill(chunk_in_corridor.begin(), chunk_in_corridor.end(), 0);
+        search_stamp = 1;
+    }
+}
+
+// Breadth-first over chunks; marks the chunks of the first chunk path found as the corridor.
+bool NavGraph::find_corridor(std::size_t from, std::size_t to) {
+    std::vector<std::uint32_t> queue{ static_cast<std::uint32_t>(from) };
+    chunk_visited[from] = search_stamp;
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const std::uint32_t c = queue[head];
+        if (c == to) {
+            for (std::uint32_t k = c;; k = chunk_came_from[k]) {
+                chunk_in_corridor[k] = search_stamp;
+                if (k == from) return true;
+            }
+        }
+        for (std::uint32_t d : chunks[c].neighbours) {
+            if (chunk_visited[d] == search_stamp) continue;
+            chunk_visited[d] = search_stamp;
+            chunk_came_from[d] = c;
+            queue.push_back(d);
+        }
+    }
+    return false;
+}
+
+bool NavGraph::search(std::uint32_t from, std::uint32_t to, bool in_corridor, std::vector<std::uint32_t>* path) {
+    const double goal = center(surfaces[to]);
+    auto estimate = [&](std::uint32_t node) {
+        return static_cast<float>(std::abs(center(surfaces[node]) - goal) / MOVE_SPEED);
+    };
+    // Priority, cost so far, node.
+    using Entry = std::tuple<float, float, std::uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    stamp[from] = search_stamp;
+    cost_so_far[from] = 0;
+    came_from[from] = NAV_NO_NODE;
+    open.push({ estimate(from), 0.0f, from });
+
+    while (!open.empty()) {
+        const auto [priority, cost_then, node] = open.top();
+        open.pop();
+        if (cost_then > cost_so_far[node]) continue; // found cheaper since
+        if (node == to) {
+            if (path) {
+                path->clear();
+                for (std::uint32_t n = to; n != NAV_NO_NODE; n = came_from[n]) path->push_back(n);
+                std::reverse(path->begin(), path->end());
+            }
+            return true;
+        }
+        for (const NavEdge& edge : edges(node)) {
+            if (in_corridor && chunk_in_corridor[node_chunk[edge.to]] != search_stamp) continue;
+            const float cost = cost_so_far[node] + edge.cost;
+            if (stamp[edge.to] == search_stamp && cost >= cost_so_far[edge.to]) continue;
+            stamp[edge.to] = search_stamp;
+            cost_so_far[edge.to] = cost;
+            came_from[edge.to] = node;
+            open.push({ cost + estimate(edge.to), cost, edge.to });
+        }
+    }
+    return false;
+}
+
+bool NavGraph::find_path(std::uint32_t from, std::uint32_t to, std::vector<std::uint32_t>& path) {
+    path.clear();
+    next_stamp();
+    bool found = false;
+    if (find_corridor(node_chunk[from], node_chunk[to])) {
+        found = search(from, to, true, &path);
+        // The corridor is one chunk path of many; the way may need a chunk beside it.
+        if (!found) {
+            next_stamp();
+            found = search(from, to, false, &path);
+        }
+    }
+    // Every node on the way reaches the goal, too.
+    for (std::uint32_t node : path) reach_cache[static_cast<std::uint64_t>(node) << 32 | to] = true;
+    if (!found) reach_cache[static_cast<std::uint64_t>(from) << 32 | to] = false;
+    return found;
+}
+
+bool NavGraph::reachable(std::uint32_t from, std::uint32_t to) {
+    auto cached = reach_cache.find(static_cast<std::uint64_t>(from) << 32 | to);
+    if (cached != reach_cache.end()) return cached->second;
+    std::vector<std::uint32_t> path;
+    return find_path(from, to, path);
+}
+
+// Calls piece(left, right) for every open interval of left edges at which a player stands
+// on `surface` without touching a hazard.
+template<typename F>
+static void clear_pieces(const Surface& surface, std::span<const Hazard> hazards, F&& piece) {
+    std::vector<std::pair<double, double>> blocked;
+    for (const Hazard& hazard : hazards) {
+        if (hazard.y < surface.y && hazard.y + hazard.height > surface.y - PLAYER_SIZE &&
+            hazard.x - PLAYER_SIZE < surface.x + surface.width && hazard.x + hazard.width > surface.x - PLAYER_SIZE) {
+            blocked.emplace_back(hazard.x - PLAYER_SIZE, hazard.x + hazard.width);
+        }
+    }
+    std::sort(blocked.begin(), blocked.end());
+    double left = surface.x - PLAYER_SIZE;
+    for (const auto& [begin, end] : blocked) {
+        if (begin > left) piece(left, begin);
+        left = std::max(left, end);
+    }
+    if (surface.x + surface.width > left) piece(left, surface.x + surface.width);
+}
+
+Surface clear_span(const Surface& surface, double player_x, std::span<const Hazard> hazards) {
+    Surface span{ player_x, surface.y, 0 };
+    clear_pieces(surface, hazards, [&](double left, double right) {
+        if (left < player_x && player_x < right) span = Surface{ left + PLAYER_SIZE, surface.y, right - left - PLAYER_SIZE };
+    });
+    return span;
+}
+
+std::vector<Surface> platform_surfaces(const World& world) {
+    std::vector<Hazard> hazards = obstacle_hazards(world);
+    std::sort(hazards.begin(), hazards.end(), [](const Hazard& a, const Hazard& b) { return a.x < b.x; });
+    double widest_hazard = 0;
+    for (const Hazard& hazard : hazards) widest_hazard = std::max(widest_hazard, hazard.width);
+    auto by_x = [](const Hazard& hazard, double x) { return hazard.x < x; };
+
+    std::vector<Surface> level;
+    level.reserve(world.geometry.platforms.size());
+    for (const Platform* platform : world.geometry.platforms) {
+        const Surface top{ platform->x, platform->y, platform->width };
+        auto first = std::lower_bound(hazards.begin(), hazards.end(), top.x - PLAYER_SIZE - widest_hazard, by_x);
+        auto last = std::lower_bound(first, hazards.end(), top.x + top.width, by_x);
+        clear_pieces(top, std::span<const Hazard>(hazards).subspan(first - hazards.begin(), last - first), [&](double left, double right) {
+            // Too short to stand on without hanging over its ends.
+            if (right - left > PLAYER_SIZE) level.push_back(Surface{ left + PLAYER_SIZE, top.y, right - left - PLAYER_SIZE });
+        });
+    }
+    return level;
+}
+
+std::vector<Hazard> obstacle_hazards(const World& world) {
+    std::vector<Hazard> hazards;
+    hazards.reserve(world.geometry.obstacles.size());
+    for (const Obstacle* obstacle : world.geometry.obstacles) {
+        hazards.push_back(Hazard{ obstacle->x, obstacle->y, obstacle->width, obstacle->height });
+    }
+    return hazards;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Jump.hpp"
+#include "LevelGen.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+const std::uint32_t NAV_NO_NODE = 0xffffffff;
+
+// Cheapest way from one platform to another; the first that works is used.
+enum NavEdgeKind : std::uint8_t {
+    NAV_WALK,        // same height, close enough to step across
+    NAV_FALL,        // walk off an edge, no jump
+    NAV_JUMP,
+    NAV_DOUBLE_JUMP,
+    NAV_TEMP_PLATFORM // a jump, an AQUA platform at its top, and a jump from there
+};
+
+struct NavEdge {
+    std::uint32_t to;
+    NavEdgeKind kind;
+    float cost; // estimated ticks
+};
+
+// Finds the cheapest move from one surface to another that touches none of `hazards`, and
+// its estimated ticks. Returns false if there is none.
+bool find_move(const Surface& from, const Surface& to, bool use_temp_platforms, std::span<const Hazard> hazards,
+    NavEdgeKind& kind, double& ticks);
+
+// --- Nav Graph: which platform tops can be reached from which, for bots and level checks ---
+// Nodes are platform surfaces, edges the moves of Jump.hpp between them that touch no
+// hazard (see platform_surfaces for hazards on the surfaces themselves). Nodes belong to the
+// chunk of width LEVEL_CHUNK_WIDTH their left edge is in, and each chunk stores the edges
+// leaving its nodes. A chunk's platforms can be replaced on their own: only the edges of that
+// chunk and of the chunks within jump range of it are worked out again, and node ids of
+// other chunks stay the same, so a huge level never needs a full rebuild after an edit.
+//
+// Paths are searched with A* over tick estimates, inside the corridor of chunks found by a
+// search over the chunk graph first. Whether one node can reach another is cached until the
+// graph next changes. Searches reuse scratch arrays, so one graph serves one thread.
+class NavGraph {
+    struct Chunk {
+        std::vector<std::uint32_t> nodes;      // sorted by x
+        std::vector<std::uint32_t> edge_begin; // edges of nodes[i]: edges[edge_begin[i], edge_begin[i + 1])
+        std::vector<NavEdge> edges;
+        std::vector<std::uint32_t> neighbours; // other chunks that edges lead into
+    };
+
+    std::vector<Chunk> chunks;
+    std::vector<Surface> surfaces;       // by node id
+    std::vector<std::uint32_t> node_chunk; // NAV_NO_NODE for free ids
+    std::vector<std::uint32_t> node_index; // position in its chunk's nodes
+    std::vector<std::uint32_t> free_ids;
+    double widest = 0; // widest surface ever added; bounds the chunks to look at for edges
+    std::vector<Hazard> hazards; // sorted by x
+    double widest_hazard = 0;
+
+    // A* scratch, by node id; valid where stamp matches search_stamp.
+    std::vector<std::uint32_t> stamp, came_from;
+    std::vector<float> cost_so_far;
+    std::vector<std::uint32_t> chunk_visited, chunk_in_corridor, chunk_came_from;
+    std::uint32_t search_stamp = 0;
+    std::unordered_map<std::uint64_t, bool> reach_cache;
+
+    std::size_t chunk_of(double x) const;
+    std::uint32_t add_node(const Surface& surface);
+    void sort_chunk(std::size_t c);
+    void link_chunk(std::size_t c);
+    bool find_corridor(std::size_t from, std::size_t to);
+    bool search(std::uint32_t from, std::uint32_t to, bool in_corridor, std::vector<std::uint32_t>* path);
+    void next_stamp();
+
+public:
+    // Without AQUA platforms there are no NAV_TEMP_PLATFORM edges, as in a world whose
+    // TempPlatformRules allow none.
+    bool use_temp_platforms = true;
+
+    // Replaces the whole graph, linking chunks on `threads` threads (0: all hardware threads).
+    void build(std::span<const Surface> level, std::span<const Hazard> obstacles, unsigned threads = 0);
+    // Replaces the nodes of one chunk by `level`, whose left edges must all lie in it. The
+    // hazards stay.
+    void update_chunk(std::size_t chunk, std::span<const Surface> level);
+
+    std::size_t node_count() const { return surfaces.size() - free_ids.size(); }
+    std::size_t edge_count() const;
+    std::size_t chunk_count() const { return chunks.size(); }
+    const Surface& surface(std::uint32_t node) const { return surfaces[node]; }
+    // Edges leaving a node.
+    std::span<const NavEdge> edges(std::uint32_t node) const;
+    // Node ids of a chunk, in x order.
+    std::span<const std::uint32_t> chunk_nodes(std::size_t chunk) const;
+    // Every hazard that a move from `from` may pass, for find_move, in x order.
+    std::span<const Hazard> hazards_near(const Surface& from) const;
+
+    // The node a player at (x, y) stands on, or NAV_NO_NODE.
+    std::uint32_t node_under(double player_x, double player_y) const;
+    // The node nearest to a player at x standing on `from`, which is not one of the graph's
+    // surfaces, that one move from there gets to and that leads on to `to`; or NAV_NO_NODE.
+    std::uint32_t entry_node(const Surface& from, double player_x, std::uint32_t to);
+
+    // Fills path with the nodes from `from` to `to`, both included. Returns false if there
+    // is no path.
+    bool find_path(std::uint32_t from, std::uint32_t to, std::vector<std::uint32_t>& path);
+    // Like find_path without the path; answers are kept until the graph changes.
+    bool reachable(std::uint32_t from, std::uint32_t to);
+};
+
+// The top surfaces of every platform of the world, for NavGraph::build, without the spans
+// where a player standing there would touch an obstacle: a platform carrying spikes gives a
+// surface on either side of them, or none.
+std::vector<Surface> platform_surfaces(const World& world);
+// Every obstacle of the world, for NavGraph::build.
+std::vector<Hazard> obstacle_hazards(const World& world);
+// The span of `surface` that a player at player_x stands on and can walk along without
+// touching one of `hazards`.
+Surface clear_span(const Surface& surface, double player_x, std::span<const Hazard> hazards);
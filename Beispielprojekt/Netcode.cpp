@@ -0,0 +1,303 @@
+#include "Netcode.hpp"
+#include "FrameTiming.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static void put_u32(unsigned char*& p, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) *p++ = static_cast<unsigned char>(v >> (8 * i));
+}
+
+static std::uint32_t get_u32(const unsigned char*& p) {
+    std::uint32_t v = p[0] | p[1] << 8 | p[2] << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+    p += 4;
+    return v;
+}
+
+// Wire format (little endian): player, player_count, 2 reserved bytes,
+// acks[player_count], first_tick, count, buttons[count].
+std::size_t encode_packet(const InputPacket& packet, unsigned char* out) {
+    unsigned char* p = out;
+    *p++ = packet.player;
+    *p++ = packet.player_count;
+    *p++ = 0;
+    *p++ = 0;
+    for (std::size_t i = 0; i < packet.player_count; ++i) put_u32(p, packet.acks[i]);
+    put_u32(p, packet.first_tick);
+    *p++ = packet.count;
+    std::memcpy(p, packet.buttons, packet.count);
+    return p + packet.count - out;
+}
+
+bool decode_packet(const unsigned char* data, std::size_t size, InputPacket& packet) {
+    const unsigned char* p = data;
+    if (size < 4) return false;
+    packet.player = p[0];
+    packet.player_count = p[1];
+    p += 4;
+    if (packet.player_count > MAX_NET_PLAYERS || packet.player >= packet.player_count ||
+        size < 4 + 4 * packet.player_count + 5u) {
+        return false;
+    }
+    for (std::size_t i = 0; i < packet.player_count; ++i) packet.acks[i] = get_u32(p);
+    packet.first_tick = get_u32(p);
+    packet.count = *p++;
+    if (packet.count > MAX_PACKET_INPUTS || size != static_cast<std::size_t>(p - data) + packet.count) {
+        return false;
+    }
+    std::memcpy(packet.buttons, p, packet.count);
+    return true;
+}
+
+// --- Loopback Network ---
+
+LoopbackNetwork::LoopbackNetwork(std::size_t peer_count, NetworkConditions conditions, std::uint32_t seed)
+    : queues(peer_count), rng(seed), conditions(conditions) {
+    for (std::size_t i = 0; i < peer_count; ++i) {
+        endpoints.push_back(std::make_unique<Endpoint>(*this, i));
+    }
+}
+
+void LoopbackNetwork::Endpoint::send(const unsigned char* data, std::size_t size) {
+    LoopbackNetwork& net = network;
+    std::uniform_real_distribution<double> chance(0, 1);
+    std::uniform_int_distribution<std::uint32_t> jitter(0, net.conditions.jitter_ticks);
+    for (std::size_t to = 0; to < net.queues.size(); ++to) {
+        if (to == index || chance(net.rng) < net.conditions.packet_loss) continue;
+        Datagram datagram = { net.now + net.conditions.latency_ticks + jitter(net.rng),
+            std::vector<unsigned char>(data, data + size) };
+        // Keep each queue sorted by delivery time; jitter may reorder datagrams.
+        auto& queue = net.queues[to];
+        auto pos = std::upper_bound(queue.begin(), queue.end(), datagram.deliver_at,
+            [](std::uint32_t t, const Datagram& d) { return t < d.deliver_at; });
+        queue.insert(pos, std::move(datagram));
+    }
+}
+
+std::size_t LoopbackNetwork::Endpoint::receive(unsigned char* data, std::size_t capacity) {
+    auto& queue = network.queues[index];
+    if (queue.empty() || queue.front().deliver_at > network.now) return 0;
+    std::size_t size = std::min(capacity, queue.front().data.size());
+    std::memcpy(data, queue.front().data.data(), size);
+    queue.pop_front();
+    return size;
+}
+
+// --- UDP Transport ---
+
+struct UdpTransport::Impl {
+#ifdef _WIN32
+    SOCKET socket = INVALID_SOCKET;
+    bool started = false;
+#else
+    int socket = -1;
+#endif
+    std::vector<sockaddr_in> peers;
+
+    ~Impl() {
+#ifdef _WIN32
+        if (socket != INVALID_SOCKET) closesocket(socket);
+        if (started) WSACleanup();
+#else
+        if (socket != -1) close(socket);
+#endif
+    }
+};
+
+static sockaddr_in make_address(const std::string& host, std::uint16_t port) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        throw std::runtime_error("Invalid IPv4 address: " + host);
+    }
+    return address;
+}
+
+UdpTransport::UdpTransport(std::uint16_t local_port, const std::vector<UdpPeer>& peers)
+    : pimpl(new Impl) {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) throw std::runtime_error("WSAStartup failed");
+    pimpl->started = true;
+#endif
+    for (const UdpPeer& peer : peers) pimpl->peers.push_back(make_address(peer.host, peer.port));
+
+    sockaddr_in local = make_address("0.0.0.0", local_port);
+    pimpl->socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+    u_long non_blocking = 1;
+    bool ok = pimpl->socket != INVALID_SOCKET &&
+        bind(pimpl->socket, reinterpret_cast<sockaddr*>(&local), sizeof local) == 0 &&
+        ioctlsocket(pimpl->socket, FIONBIO, &non_blocking) == 0;
+#else
+    bool ok = pimpl->socket != -1 &&
+        bind(pimpl->socket, reinterpret_cast<sockaddr*>(&local), sizeof local) == 0 &&
+        fcntl(pimpl->socket, F_SETFL, fcntl(pimpl->socket, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+    if (!ok) throw std::runtime_error("Could not open UDP port " + std::to_string(local_port));
+}
+
+UdpTransport::~UdpTransport() = default;
+
+void UdpTransport::send(const unsigned char* data, std::size_t size) {
+    for (const sockaddr_in& peer : pimpl->peers) {
+        sendto(pimpl->socket, reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+            reinterpret_cast<const sockaddr*>(&peer), sizeof peer);
+    }
+}
+
+std::size_t UdpTransport::receive(unsigned char* data, std::size_t capacity) {
+    auto received = recvfrom(pimpl->socket, reinterpret_cast<char*>(data),
+        static_cast<int>(capacity), 0, nullptr, nullptr);
+    return received > 0 ? static_cast<std::size_t>(received) : 0;
+}
+
+// --- Rollback Session ---
+
+RollbackSession::RollbackSession(World& world, Transport& transport, std::size_t local_player,
+    std::uint32_t max_rollback)
+    : world(world), transport(transport), local_player(local_player), max_rollback(max_rollback),
+    snapshots(max_rollback + 1, world),
+    inputs(world.players.size()), confirmed(world.players.size()),
+    confirmed_until(world.players.size(), world.tick), peer_acks(world.players.size(), world.tick),
+    frame_buttons(world.players.size()), rollback_from(world.tick) {
+    if (world.players.size() > MAX_NET_PLAYERS) {
+        throw std::invalid_argument("Too many players for a rollback session");
+    }
+}
+
+std::uint8_t& RollbackSession::input_at(std::size_t player, std::uint32_t tick) {
+    if (inputs[player].size() <= tick) {
+        // Grow in chunks so a long session does not reallocate every tick.
+        inputs[player].resize(tick + 1 + TICKS_PER_SECOND * 60, 0);
+        confirmed[player].resize(inputs[player].size(), 0);
+    }
+    return inputs[player][tick];
+}
+
+void RollbackSession::confirm(std::size_t player, std::uint32_t tick, std::uint8_t buttons) {
+    // Peers can only be a few ticks ahead; anything further is garbage.
+    if (tick >= world.tick + TICKS_PER_SECOND * 60) return;
+    std::uint8_t& used = input_at(player, tick);
+    if (confirmed[player][tick]) return;
+
+    // Already simulated with a different prediction: re-run from there.
+    if (tick < world.tick && used != buttons) rollback_from = std::min(rollback_from, tick);
+    used = buttons;
+    confirmed[player][tick] = 1;
+
+    std::uint32_t& until = confirmed_until[player];
+    while (until < confirmed[player].size() && confirmed[player][until]) ++until;
+}
+
+void RollbackSession::receive_packets() {
+    unsigned char data[MAX_PACKET_SIZE];
+    InputPacket packet;
+    while (std::size_t size = transport.receive(data, sizeof data)) {
+        if (!decode_packet(data, size, packet) || packet.player_count != world.players.size() ||
+            packet.player == local_player) {
+            continue;
+        }
+        peer_acks[packet.player] = std::max(peer_acks[packet.player], packet.acks[local_player]);
+        for (std::uint32_t i = 0; i < packet.count; ++i) {
+            confirm(packet.player, packet.first_tick + i, packet.buttons[i]);
+        }
+    }
+}
+
+void RollbackSession::send_local_inputs() {
+    InputPacket packet;
+    packet.player = static_cast<std::uint8_t>(local_player);
+    packet.player_count = static_cast<std::uint8_t>(world.players.size());
+    const std::uint32_t end = confirmed_until[local_player];
+    std::uint32_t oldest_unacked = end;
+    for (std::size_t p = 0; p < world.players.size(); ++p) {
+        packet.acks[p] = confirmed_until[p];
+        if (p != local_player) oldest_unacked = std::min(oldest_unacked, peer_acks[p]);
+    }
+    const std::uint32_t window = static_cast<std::uint32_t>(MAX_PACKET_INPUTS);
+    packet.first_tick = std::max(oldest_unacked, end > window ? end - window : 0);
+    packet.count = static_cast<std::uint8_t>(end - packet.first_tick);
+    for (std::uint32_t i = 0; i < packet.count; ++i) {
+        packet.buttons[i] = input_at(local_player, packet.first_tick + i);
+    }
+
+    unsigned char data[MAX_PACKET_SIZE];
+    transport.send(data, encode_packet(packet, data));
+}
+
+void RollbackSession::simulate_tick() {
+    const std::uint32_t tick = world.tick;
+    for (std::size_t p = 0; p < world.players.size(); ++p) {
+        std::uint8_t& buttons = input_at(p, tick);
+        if (!confirmed[p][tick]) {
+            // Predict: the player keeps holding whatever they held last.
+            std::uint32_t last = confirmed_until[p];
+            buttons = last > 0 ? inputs[p][last - 1] : 0;
+        }
+        frame_buttons[p] = buttons;
+    }
+    snapshots.save(world);
+    world.step(frame_buttons.data());
+}
+
+void RollbackSession::resolve_rollback() {
+    const std::uint32_t now = world.tick;
+    if (rollback_from < now) {
+        const std::uint64_t start = nanoseconds();
+        snapshots.restore(world, rollback_from);
+        while (world.tick < now) {
+            simulate_tick();
+            ++stats.resimulated_ticks;
+        }
+        stats.resimulation_seconds += seconds_since(start);
+        ++stats.rollbacks;
+    }
+    rollback_from = now;
+}
+
+void RollbackSession::poll() {
+    receive_packets();
+    resolve_rollback();
+    send_local_inputs();
+}
+
+bool RollbackSession::advance(std::uint8_t local_buttons) {
+    receive_packets();
+    resolve_rollback();
+
+    const std::uint32_t now = world.tick;
+    for (std::size_t p = 0; p < world.players.size(); ++p) {
+        if (p != local_player && confirmed_until[p] + max_rollback <= now) {
+            ++stats.stalls;
+            send_local_inputs();
+            return false;
+        }
+    }
+
+    confirm(local_player, now, local_buttons);
+    send_local_inputs();
+    simulate_tick();
+    rollback_from = world.tick;
+    ++stats.ticks;
+    return true;
+}
+
+std::uint32_t RollbackSession::confirmed_tick() const {
+    return *std::min_element(confirmed_until.begin(), confirmed_until.end());
+}
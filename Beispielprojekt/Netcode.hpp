@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Snapshot.hpp"
+#include "World.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+const std::size_t MAX_NET_PLAYERS = 8;
+const std::size_t MAX_PACKET_INPUTS = 64;
+const std::size_t MAX_PACKET_SIZE = 4 + 4 * MAX_NET_PLAYERS + 4 + 1 + MAX_PACKET_INPUTS;
+
+// --- Input Packet: one player's buttons for a run of ticks, plus what it has received ---
+// Every packet repeats all inputs the peers have not acknowledged yet, so a lost packet
+// never needs to be resent on its own.
+struct InputPacket {
+    std::uint8_t player = 0;
+    std::uint8_t player_count = 0;
+    // acks[p]: the sender has confirmed all inputs of player p before this tick.
+    std::uint32_t acks[MAX_NET_PLAYERS] = {};
+    std::uint32_t first_tick = 0;
+    std::uint8_t count = 0;
+    std::uint8_t buttons[MAX_PACKET_INPUTS] = {};
+};
+
+std::size_t encode_packet(const InputPacket& packet, unsigned char* out);
+bool decode_packet(const unsigned char* data, std::size_t size, InputPacket& packet);
+
+// --- Transport: sends datagrams to every other peer, receives theirs ---
+class Transport {
+public:
+    virtual ~Transport() {}
+    virtual void send(const unsigned char* data, std::size_t size) = 0;
+    // Returns the size of the next waiting datagram, or 0 if there is none.
+    virtual std::size_t receive(unsigned char* data, std::size_t capacity) = 0;
+};
+
+// --- Loopback Network: in-process peers with simulated latency, jitter and loss ---
+struct NetworkConditions {
+    std::uint32_t latency_ticks = 0;
+    std::uint32_t jitter_ticks = 0;
+    double packet_loss = 0;
+};
+
+class LoopbackNetwork {
+    struct Datagram {
+        std::uint32_t deliver_at;
+        std::vector<unsigned char> data;
+    };
+
+    class Endpoint : public Transport {
+        LoopbackNetwork& network;
+        std::size_t index;
+    public:
+        Endpoint(LoopbackNetwork& network, std::size_t index) : network(network), index(index) {}
+        void send(const unsigned char* data, std::size_t size) override;
+        std::size_t receive(unsigned char* data, std::size_t capacity) override;
+    };
+
+    std::vector<std::unique_ptr<Endpoint>> endpoints;
+    std::vector<std::deque<Datagram>> queues;
+    std::mt19937 rng;
+    std::uint32_t now = 0;
+
+public:
+    NetworkConditions conditions;
+
+    LoopbackNetwork(std::size_t peer_count, NetworkConditions conditions, std::uint32_t seed = 1);
+
+    Transport& endpoint(std::size_t index) { return *endpoints[index]; }
+
+    // Moves simulated time on by one tick.
+    void advance() { ++now; }
+};
+
+// --- UDP Transport: real sockets, e.g. several processes on 127.0.0.1 ---
+struct UdpPeer {
+    std::string host;
+    std::uint16_t port;
+};
+
+class UdpTransport : public Transport {
+    struct Impl;
+    std::unique_ptr<Impl> pimpl;
+public:
+    UdpTransport(std::uint16_t local_port, const std::vector<UdpPeer>& peers);
+    ~UdpTransport();
+    void send(const unsigned char* data, std::size_t size) override;
+    std::size_t receive(unsigned char* data, std::size_t capacity) override;
+};
+
+// --- Rollback Session: predicts remote input and re-simulates when it was wrong ---
+struct RollbackStats {
+    std::uint64_t ticks = 0;
+    std::uint64_t stalls = 0;
+    std::uint64_t rollbacks = 0;
+    std::uint64_t resimulated_ticks = 0;
+    double resimulation_seconds = 0;
+};
+
+class RollbackSession {
+    World& world;
+    Transport& transport;
+    std::size_t local_player;
+    std::uint32_t max_rollback;
+    SnapshotRing snapshots;
+
+    // Per player and tick: the buttons used (or predicted) for that tick.
+    std::vector<std::vector<std::uint8_t>> inputs;
+    std::vector<std::vector<std::uint8_t>> confirmed;
+    // confirmed_until[p]: all inputs of player p before this tick are known.
+    std::vector<std::uint32_t> confirmed_until;
+    // peer_acks[p]: player p has confirmed our inputs before this tick.
+    std::vector<std::uint32_t> peer_acks;
+    std::vector<std::uint8_t> frame_buttons;
+    std::uint32_t rollback_from;
+    RollbackStats stats;
+
+    void receive_packets();
+    void send_local_inputs();
+    void confirm(std::size_t player, std::uint32_t tick, std::uint8_t buttons);
+    void simulate_tick();
+    void resolve_rollback();
+    std::uint8_t& input_at(std::size_t player, std::uint32_t tick);
+
+public:
+    // Every player in the world is one peer; local_player is the one driven by this process.
+    RollbackSession(World& world, Transport& transport, std::size_t local_player,
+        std::uint32_t max_rollback = 8);
+
+    // Runs one tick with the local player's buttons. Returns false (and does not advance)
+    // while some peer's confirmed input lags more than max_rollback ticks behind.
+    bool advance(std::uint8_t local_buttons);
+
+    // Handles late input (rolling back if needed) and resends our own, without advancing.
+    void poll();
+
+    // All inputs of all players before this tick are confirmed, so world state up to it is final.
+    std::uint32_t confirmed_tick() const;
+
+    const RollbackStats& statistics() const { return stats; }
+};
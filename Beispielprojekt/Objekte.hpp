@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Gosu/Gosu.hpp>
+
+// --- Base Object Class ---
+class Objekt {
+public:
+    double x, y, width, height;
+    Objekt(double x, double y, double width, double height)
+        : x(x), y(y), width(width), height(height) {
+    }
+    virtual void draw(Gosu::Graphics& graphics) = 0;
+    virtual ~Objekt() {}
+};
+
+// --- Platform Class: Now supports color! ---
+class Platform : public Objekt {
+    Gosu::Color color;
+public:
+    Platform(double x, double y, double width, double height, Gosu::Color color = Gosu::Color::GRAY)
+        : Objekt(x, y, width, height), color(color) {
+    }
+    void draw(Gosu::Graphics& graphics) override {
+        graphics.draw_rect(x, y, width, height, color, 0.0);
+    }
+};
+
+// --- Obstacle (Triangle Spike) Class ---
+class Obstacle : public Objekt {
+public:
+    Obstacle(double x, double y, double size) : Objekt(x, y, size, size) {}
+    void draw(Gosu::Graphics& graphics) override {
+        graphics.draw_triangle(
+            x, y + height, Gosu::Color::RED,
+            x + width / 2, y, Gosu::Color::RED,
+            x + width, y + height, Gosu::Color::RED,
+            0.0
+        );
+    }
+};
+
+inline bool rects_overlap(const Objekt& a, const Objekt& b) {
+    return a.x < b.x + b.width &&
+        a.x + a.width > b.x &&
+        a.y < b.y + b.height &&
+        a.y + a.height > b.y;
+}
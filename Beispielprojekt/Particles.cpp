@@ -0,0 +1,162 @@
+#include "Particles.hpp"
+#include "Profiler.hpp"
+#include <Gosu/Bitmap.hpp>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLES_SSE2
+#endif
+
+const std::size_t PARTICLE_LANES = 4;
+
+ParticleSystem::ParticleSystem(std::size_t capacity) {
+    const std::size_t padded = (capacity + PARTICLE_LANES - 1) / PARTICLE_LANES * PARTICLE_LANES;
+    for (std::vector<float>* field : { &x, &y, &velocity_x, &velocity_y, &gravity, &remaining, &life, &diameter }) {
+        field->resize(padded);
+    }
+    color.resize(padded);
+}
+
+// xorshift32; effects need no better randomness, and this keeps emit() cheap.
+float ParticleSystem::random_unit() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return (random_state >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleSystem::emit(const ParticleBurst& burst) {
+    const std::size_t count = std::min<std::size_t>(burst.count, capacity() - live);
+    for (std::size_t n = 0; n < count; ++n, ++live) {
+        const float angle = burst.angle + (random_unit() - 0.5f) * burst.spread;
+        const float speed = burst.min_speed + random_unit() * (burst.max_speed - burst.min_speed);
+        x[live] = burst.x;
+        y[live] = burst.y;
+        velocity_x[live] = std::cos(angle) * speed;
+        velocity_y[live] = std::sin(angle) * speed;
+        gravity[live] = burst.gravity;
+        life[live] = burst.life * (0.5f + 0.5f * random_unit());
+        remaining[live] = life[live];
+        diameter[live] = burst.size;
+        color[live] = burst.color.argb();
+    }
+}
+
+void ParticleSystem::emit(const std::vector<WorldEvent>& events) {
+    const float pi = 3.14159265f;
+    for (const WorldEvent& event : events) {
+        const float ex = static_cast<float>(event.x), ey = static_cast<float>(event.y);
+        ParticleBurst burst = {};
+        switch (event.type) {
+        case EVENT_DEATH:
+            burst = { ex, ey, 400, 0, 2 * pi, 1, 7, 0.15f, 70, 5, Gosu::Color(0xff, 0xff, 0x40, 0x20) };
+            break;
+        case EVENT_LANDING:
+            burst = { ex, ey, 24, -pi / 2, pi, 0.3f, 1.5f, 0.02f, 20, 4, Gosu::Color(0x90, 0xc0, 0xb0, 0x90) };
+            break;
+        case EVENT_PLATFORM_PLACED:
+            burst = { ex, ey, 80, -pi / 2, pi / 2, 0.5f, 2.5f, 0.05f, 35, 4, Gosu::Color(0xc0, 0x40, 0xff, 0xff) };
+            break;
+        case EVENT_PLATFORM_EXPIRED:
+            burst = { ex, ey, 60, pi / 2, pi, 0.2f, 1.2f, 0.08f, 40, 4, Gosu::Color(0x90, 0x40, 0xc0, 0xc0) };
+            break;
+        }
+        emit(burst);
+    }
+}
+
+void ParticleSystem::remove(std::size_t i) {
+    const std::size_t last = --live;
+    x[i] = x[last];
+    y[i] = y[last];
+    velocity_x[i] = velocity_x[last];
+    velocity_y[i] = velocity_y[last];
+    gravity[i] = gravity[last];
+    remaining[i] = remaining[last];
+    life[i] = life[last];
+    diameter[i] = diameter[last];
+    color[i] = color[last];
+}
+
+void ParticleSystem::update() {
+    PROFILE_ZONE("particles");
+    const std::size_t groups = (live + PARTICLE_LANES - 1) / PARTICLE_LANES;
+    float* px = x.data();
+    float* py = y.data();
+    float* vx = velocity_x.data();
+    float* vy = velocity_y.data();
+    const float* ay = gravity.data();
+    float* left = remaining.data();
+
+#ifdef PARTICLES_SSE2
+    const __m128 drag = _mm_set1_ps(PARTICLE_DRAG);
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (std::size_t g = 0; g < groups; ++g) {
+        const std::size_t i = g * PARTICLE_LANES;
+        __m128 v_x = _mm_mul_ps(_mm_loadu_ps(vx + i), drag);
+        __m128 v_y = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vy + i), _mm_loadu_ps(ay + i)), drag);
+        _mm_storeu_ps(vx + i, v_x);
+        _mm_storeu_ps(vy + i, v_y);
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), v_x));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), v_y));
+        _mm_storeu_ps(left + i, _mm_sub_ps(_mm_loadu_ps(left + i), one));
+    }
+#else
+    for (std::size_t i = 0; i < groups * PARTICLE_LANES; ++i) {
+        vx[i] *= PARTICLE_DRAG;
+        vy[i] = (vy[i] + ay[i]) * PARTICLE_DRAG;
+        px[i] += vx[i];
+        py[i] += vy[i];
+        left[i] -= 1.0f;
+    }
+#endif
+
+    // Most groups have no dead particle; only those are looked at one by one. A removed
+    // particle's place is taken by the last one, which is checked in turn.
+    for (std::size_t i = 0; i < live;) {
+#ifdef PARTICLES_SSE2
+        if (i + PARTICLE_LANES <= live &&
+            _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(left + i), _mm_setzero_ps())) == 0) {
+            i += PARTICLE_LANES;
+            continue;
+        }
+#endif
+        if (left[i] <= 0) remove(i);
+        else ++i;
+    }
+}
+
+static Gosu::Bitmap dot_bitmap() {
+    // A soft round dot: white, with alpha falling off towards the edge.
+    Gosu::Bitmap bitmap(PARTICLE_DOT_SIZE, PARTICLE_DOT_SIZE);
+    const double center = (PARTICLE_DOT_SIZE - 1) / 2.0;
+    for (int py = 0; py < PARTICLE_DOT_SIZE; ++py) {
+        for (int px = 0; px < PARTICLE_DOT_SIZE; ++px) {
+            const double distance = std::hypot(px - center, py - center) / (PARTICLE_DOT_SIZE / 2.0);
+            const double alpha = std::clamp(1.0 - distance * distance, 0.0, 1.0);
+            bitmap.set_pixel(px, py, Gosu::Color(static_cast<Gosu::Color::Channel>(alpha * 255), 0xff, 0xff, 0xff));
+        }
+    }
+    return bitmap;
+}
+
+std::uint32_t ParticleSystem::draw(double view_left, double view_top, double view_right,
+    double view_bottom, Gosu::ZPos z) {
+    if (!dot) dot = std::make_unique<Gosu::Image>(dot_bitmap());
+    std::uint32_t quads = 0;
+    for (std::size_t i = 0; i < live; ++i) {
+        const double half = diameter[i] / 2;
+        if (x[i] + half < view_left || x[i] - half > view_right ||
+            y[i] + half < view_top || y[i] - half > view_bottom) {
+            continue;
+        }
+        Gosu::Color c(color[i]);
+        c.set_alpha(static_cast<Gosu::Color::Channel>(c.alpha() * remaining[i] / life[i]));
+        const double scale = diameter[i] / PARTICLE_DOT_SIZE;
+        dot->draw(x[i] - half, y[i] - half, z, scale, scale, c, Gosu::BM_ADD);
+        ++quads;
+    }
+    return quads;
+}
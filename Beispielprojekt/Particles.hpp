@@ -0,0 +1,62 @@
+#pragma once
+
+#include "World.hpp"
+#include <Gosu/Color.hpp>
+#include <Gosu/GraphicsBase.hpp>
+#include <Gosu/Image.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+const std::size_t PARTICLE_CAPACITY = 1 << 17;
+const float PARTICLE_DRAG = 0.98f; // velocity kept per tick
+const int PARTICLE_DOT_SIZE = 8;   // pixels of the shared dot texture
+
+// --- Particle Burst: count particles thrown out of one point ---
+struct ParticleBurst {
+    float x, y;
+    std::uint32_t count;
+    float angle, spread;  // direction of the cone and its full width, radians (0 = right)
+    float min_speed, max_speed; // pixels per tick
+    float gravity;        // pixels per tick², added to the vertical speed
+    std::uint32_t life;   // ticks; each particle gets between half and all of it
+    float size;           // pixels across
+    Gosu::Color color;
+};
+
+// --- Particle System: purely visual particles, outside of the deterministic World ---
+// Particles are stored as one array per field. Live particles are packed at the front, so
+// update() integrates four at a time with SSE2 (scalar elsewhere). Dead particles are
+// replaced by the last live one, so nothing is allocated after construction.
+// Drawing uses one small texture with BM_ADD for every particle, so Gosu batches them all.
+class ParticleSystem {
+    // Rounded up to whole SIMD groups; the lanes past size() are integrated but never used.
+    std::vector<float> x, y, velocity_x, velocity_y, gravity;
+    std::vector<float> remaining, life, diameter;
+    std::vector<std::uint32_t> color; // ARGB
+    std::size_t live = 0;
+    std::uint32_t random_state = 0x9e3779b9;
+    std::unique_ptr<Gosu::Image> dot; // created on first draw, which needs a window
+
+    float random_unit();
+    void remove(std::size_t i);
+
+public:
+    explicit ParticleSystem(std::size_t capacity = PARTICLE_CAPACITY);
+
+    std::size_t size() const { return live; }
+    std::size_t capacity() const { return x.size(); }
+
+    // Particles that do not fit any more are dropped.
+    void emit(const ParticleBurst& burst);
+    // Bursts for the events of the last World::step.
+    void emit(const std::vector<WorldEvent>& events);
+
+    // Advances every particle by one tick and removes the ones that have run out.
+    void update();
+
+    // Draws the particles inside the given area, fading them out over their life.
+    // Returns the number of quads drawn.
+    std::uint32_t draw(double left, double top, double right, double bottom, Gosu::ZPos z);
+};
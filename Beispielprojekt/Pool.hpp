@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+const std::uint32_t POOL_NO_SLOT = 0xffffffff;
+
+// --- Pool Handle: names one pooled object, and nothing else once that object is gone ---
+struct PoolHandle {
+    std::uint32_t slot = POOL_NO_SLOT;
+    std::uint32_t generation = 0;
+
+    bool operator==(const PoolHandle&) const = default;
+};
+
+// --- Pool: fixed-capacity set of short-lived objects with generational handles ---
+// Columns is a struct of arrays like Players, with a static for_each_field. Live objects
+// are packed at indices 0 to size() - 1 of every column, so update and draw loops run over
+// plain arrays. Despawning moves the last object into the hole. Handles go through a slot
+// table and stay valid across such moves. A slot's generation is bumped when its object is
+// despawned, so stale handles are rejected instead of naming a newer object.
+// Spawning and despawning are O(1) and never allocate; only reserve() does.
+template<typename Columns>
+class Pool {
+    std::vector<std::uint32_t> generations; // per slot
+    std::vector<std::uint32_t> slot_index;  // slot -> index into the columns
+    std::vector<std::uint32_t> index_slot;  // index -> slot; [size(), capacity()) are the free slots
+    std::uint32_t live = 0;
+
+public:
+    Columns columns;
+
+    std::size_t size() const { return live; }
+    std::size_t capacity() const { return index_slot.size(); }
+    bool full() const { return live == index_slot.size(); }
+
+    // Grows the capacity. Handles and indices stay valid.
+    void reserve(std::size_t capacity) {
+        for (std::size_t slot = index_slot.size(); slot < capacity; ++slot) {
+            generations.push_back(0);
+            slot_index.push_back(static_cast<std::uint32_t>(slot));
+            index_slot.push_back(static_cast<std::uint32_t>(slot));
+        }
+        Columns::for_each_field(columns, [&](auto& field) {
+            if (field.size() < index_slot.size()) field.resize(index_slot.size());
+        });
+    }
+
+    // The new object is at index size() - 1; the caller fills in its columns.
+    // Returns an invalid handle if the pool is full.
+    PoolHandle spawn() {
+        if (full()) return PoolHandle();
+        const std::uint32_t slot = index_slot[live];
+        slot_index[slot] = live++;
+        return PoolHandle{ slot, generations[slot] };
+    }
+
+    bool contains(PoolHandle handle) const {
+        return handle.slot < generations.size() && generations[handle.slot] == handle.generation &&
+            slot_index[handle.slot] < live;
+    }
+
+    // Index of the object in the columns; only valid until the next despawn.
+    std::size_t index(PoolHandle handle) const { return slot_index[handle.slot]; }
+    // Same for a slot that is known to be live, e.g. one handed out by a TimerWheel.
+    std::size_t index_of_slot(std::uint32_t slot) const { return slot_index[slot]; }
+
+    PoolHandle handle(std::size_t index) const {
+        const std::uint32_t slot = index_slot[index];
+        return PoolHandle{ slot, generations[slot] };
+    }
+
+    // Removes the object at index; the last object takes its place. When despawning while
+    // iterating, go backwards or do not advance past index.
+    void despawn_at(std::size_t index) {
+        const std::uint32_t last = live - 1;
+        const std::uint32_t slot = index_slot[index];
+        const std::uint32_t moved = index_slot[last];
+        Columns::for_each_field(columns, [&](auto& field) { field[index] = field[last]; });
+        index_slot[index] = moved;
+        slot_index[moved] = static_cast<std::uint32_t>(index);
+        index_slot[last] = slot;
+        slot_index[slot] = last;
+        ++generations[slot];
+        --live;
+    }
+
+    // Returns false if the handle was stale.
+    bool despawn(PoolHandle handle) {
+        if (!contains(handle)) return false;
+        despawn_at(slot_index[handle.slot]);
+        return true;
+    }
+
+    void clear() {
+        while (live > 0) despawn_at(live - 1);
+    }
+
+    // Calls f on every array that makes up the pool's state, for snapshots. Every array is
+    // capacity() long, apart from the live count.
+    template<typename Self, typename F>
+    static void for_each_field(Self& self, F&& f) {
+        Columns::for_each_field(self.columns, f);
+        f(self.generations); f(self.slot_index); f(self.index_slot);
+        auto live = std::span(&self.live, 1);
+        f(live);
+    }
+};
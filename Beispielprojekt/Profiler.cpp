@@ -0,0 +1,131 @@
+#include "Profiler.hpp"
+#include <Gosu/IO.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> profiler_active{false};
+
+static_assert((PROFILER_RING_SIZE & (PROFILER_RING_SIZE - 1)) == 0, "Ring size must be a power of two");
+
+// Fields are relaxed atomics only so that exporting while the owner writes is not a data
+// race; on x86 they compile to plain loads and stores.
+struct ProfileEvent {
+    std::atomic<const char*> name;
+    std::atomic<std::uint64_t> start, end;
+};
+
+struct ProfileRing {
+    std::unique_ptr<ProfileEvent[]> events{new ProfileEvent[PROFILER_RING_SIZE]};
+    // Zones recorded so far; zone i lives in events[i % PROFILER_RING_SIZE].
+    std::atomic<std::uint64_t> head{0};
+};
+
+// Rings are never freed, so zones of threads that have finished can still be exported.
+static std::mutex& rings_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::vector<std::unique_ptr<ProfileRing>>& rings() {
+    static std::vector<std::unique_ptr<ProfileRing>> all;
+    return all;
+}
+
+// The moment timestamps are measured from, in both profiler_timestamp units and steady_clock
+// nanoseconds, so an export can work out how many timestamp units make a microsecond.
+struct ClockOrigin {
+    std::uint64_t timestamp;
+    std::chrono::steady_clock::time_point time;
+};
+
+static const ClockOrigin& clock_origin() {
+    static const ClockOrigin origin = { profiler_timestamp(), std::chrono::steady_clock::now() };
+    return origin;
+}
+
+static ProfileRing* register_thread() {
+    clock_origin();
+    std::lock_guard<std::mutex> lock(rings_mutex());
+    rings().push_back(std::make_unique<ProfileRing>());
+    return rings().back().get();
+}
+
+void profiler_record(const char* name, std::uint64_t start, std::uint64_t end) {
+    // Constant-initialized, so the fast path needs no thread_local guard.
+    thread_local ProfileRing* ring = nullptr;
+    if (!ring) ring = register_thread();
+    const std::uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ProfileEvent& event = ring->events[head & (PROFILER_RING_SIZE - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void profiler_set_recording(bool recording) {
+    clock_origin();
+    profiler_active.store(recording, std::memory_order_relaxed);
+}
+
+static void append_json_string(std::string& out, const char* text) {
+    out += '"';
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\') out += '\\';
+        if (static_cast<unsigned char>(*text) >= 0x20) out += *text;
+    }
+    out += '"';
+}
+
+std::size_t write_chrome_trace(const std::string& filename) {
+    const ClockOrigin& origin = clock_origin();
+    const double elapsed_us = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - origin.time).count();
+    const double units = static_cast<double>(profiler_timestamp() - origin.timestamp);
+    const double us_per_unit = units > 0 && elapsed_us > 0 ? elapsed_us / units : 1e-3;
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    std::size_t count = 0;
+    char number[96];
+
+    std::lock_guard<std::mutex> lock(rings_mutex());
+    for (std::size_t thread = 0; thread < rings().size(); ++thread) {
+        const ProfileRing& ring = *rings()[thread];
+        const std::uint64_t end = ring.head.load(std::memory_order_acquire);
+        const std::uint64_t begin = end > PROFILER_RING_SIZE ? end - PROFILER_RING_SIZE : 0;
+
+        std::vector<std::uint64_t> starts, ends;
+        std::vector<const char*> names;
+        for (std::uint64_t i = begin; i < end; ++i) {
+            const ProfileEvent& event = ring.events[i & (PROFILER_RING_SIZE - 1)];
+            names.push_back(event.name.load(std::memory_order_relaxed));
+            starts.push_back(event.start.load(std::memory_order_relaxed));
+            ends.push_back(event.end.load(std::memory_order_relaxed));
+        }
+        // Zone i may have been overwritten since, once zone i + PROFILER_RING_SIZE was begun.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::uint64_t head_after = ring.head.load(std::memory_order_relaxed);
+        const std::uint64_t valid_from =
+            head_after >= PROFILER_RING_SIZE ? head_after - PROFILER_RING_SIZE + 1 : 0;
+
+        for (std::uint64_t i = std::max(begin, valid_from); i < end; ++i) {
+            const std::size_t k = static_cast<std::size_t>(i - begin);
+            if (starts[k] < origin.timestamp || ends[k] < starts[k]) continue;
+            if (count++ > 0) json += ',';
+            json += "{\"name\":";
+            append_json_string(json, names[k]);
+            std::snprintf(number, sizeof number,
+                ",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}", thread,
+                (starts[k] - origin.timestamp) * us_per_unit, (ends[k] - starts[k]) * us_per_unit);
+            json += number;
+        }
+    }
+    json += "]}\n";
+
+    Gosu::File file(filename, Gosu::FM_REPLACE);
+    file.write(0, json.size(), json.data());
+    return count;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "FrameTiming.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILER_RDTSC
+#endif
+
+// --- Profiler: scoped timing zones, exported as a Chrome trace (chrome://tracing, Perfetto) ---
+// Every thread that records a zone gets its own ring of the last PROFILER_RING_SIZE zones.
+// Only that thread writes to it, so recording takes no lock; exporting copies the rings
+// and drops whatever was overwritten while it copied.
+// Build with NO_PROFILER defined to remove all zones from the code. Otherwise a zone costs
+// one relaxed load while recording is off, and two timestamps plus a ring write while on.
+const std::size_t PROFILER_RING_SIZE = 1 << 16;
+
+extern std::atomic<bool> profiler_active;
+
+inline bool profiler_recording() {
+    return profiler_active.load(std::memory_order_relaxed);
+}
+
+// Raw timestamp: TSC ticks on x86-64 (assumed invariant, as on every CPU of the last
+// decade), nanoseconds() elsewhere. write_chrome_trace converts them.
+inline std::uint64_t profiler_timestamp() {
+#ifdef PROFILER_RDTSC
+    return __rdtsc();
+#else
+    return nanoseconds();
+#endif
+}
+
+// name must outlive the profiler, e.g. a string literal.
+void profiler_record(const char* name, std::uint64_t start, std::uint64_t end);
+
+void profiler_set_recording(bool recording);
+
+// Writes all zones still in the rings as Chrome trace JSON. Returns the number of zones.
+std::size_t write_chrome_trace(const std::string& filename);
+
+class ProfileZone {
+    const char* name;
+    std::uint64_t start;
+
+public:
+    explicit ProfileZone(const char* name)
+        : name(name), start(profiler_recording() ? profiler_timestamp() : 0) {
+    }
+    ~ProfileZone() {
+        if (start) profiler_record(name, start, profiler_timestamp());
+    }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+#ifdef NO_PROFILER
+#define PROFILE_ZONE(name) ((void)0)
+#else
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing scope.
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#endif
@@ -0,0 +1,169 @@
+#include "Replay.hpp"
+#include "Snapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+static const std::uint32_t REPLAY_MAGIC = 0x594c5052; // "RPLY"
+static const std::uint32_t REPLAY_INDEX_MAGIC = 0x58444952; // "RIDX"
+static const std::uint32_t REPLAY_VERSION = 2;
+static const std::uint8_t REPLAY_TICK = 0;
+static const std::uint8_t REPLAY_KEYFRAME = 1;
+static const std::size_t REPLAY_FOOTER_SIZE = 16;
+
+ReplayWriter::ReplayWriter(const std::string& filename, const World& world,
+    std::uint32_t keyframe_interval)
+    : file(std::make_unique<AsyncFile>(filename)), writer(file->back_writer()),
+    keyframe_interval(keyframe_interval), first_tick(world.tick),
+    last_buttons(world.players.size(), 0) {
+    write_header();
+}
+
+ReplayWriter::ReplayWriter(Gosu::Resource& sink, const World& world,
+    std::uint32_t keyframe_interval)
+    : writer(sink.back_writer()), keyframe_interval(keyframe_interval),
+    first_tick(world.tick), last_buttons(world.players.size(), 0) {
+    write_header();
+}
+
+void ReplayWriter::write_header() {
+    if (last_buttons.size() > 0xffff || keyframe_interval == 0) {
+        throw std::invalid_argument("Cannot record this world into a replay");
+    }
+    writer.write_pod(REPLAY_MAGIC, Gosu::BO_LITTLE);
+    writer.write_pod(REPLAY_VERSION, Gosu::BO_LITTLE);
+    writer.write_pod(static_cast<std::uint32_t>(last_buttons.size()), Gosu::BO_LITTLE);
+    writer.write_pod(keyframe_interval, Gosu::BO_LITTLE);
+}
+
+ReplayWriter::~ReplayWriter() {
+    try {
+        finish();
+    }
+    catch (...) {
+        // A destructor must not throw; the replay is just left without an index.
+    }
+}
+
+void ReplayWriter::record(const World& world, const std::uint8_t* buttons) {
+    if (ticks % keyframe_interval == 0) {
+        index.emplace_back(world.tick, writer.position());
+        writer.write_pod(REPLAY_KEYFRAME);
+        write_snapshot(writer, world);
+        writer.write(last_buttons.data(), last_buttons.size());
+    }
+
+    std::uint16_t changes = 0;
+    for (std::size_t p = 0; p < last_buttons.size(); ++p) changes += buttons[p] != last_buttons[p];
+    writer.write_pod(REPLAY_TICK);
+    writer.write_pod(changes, Gosu::BO_LITTLE);
+    for (std::size_t p = 0; p < last_buttons.size(); ++p) {
+        if (buttons[p] == last_buttons[p]) continue;
+        writer.write_pod(static_cast<std::uint16_t>(p), Gosu::BO_LITTLE);
+        writer.write_pod(buttons[p]);
+        last_buttons[p] = buttons[p];
+    }
+    ++ticks;
+}
+
+void ReplayWriter::finish() {
+    if (finished) return;
+    finished = true;
+
+    std::uint64_t index_offset = writer.position();
+    writer.write_pod(static_cast<std::uint32_t>(index.size()), Gosu::BO_LITTLE);
+    for (const auto& entry : index) {
+        writer.write_pod(entry.first, Gosu::BO_LITTLE);
+        writer.write_pod(entry.second, Gosu::BO_LITTLE);
+    }
+    writer.write_pod(ticks, Gosu::BO_LITTLE);
+    writer.write_pod(index_offset, Gosu::BO_LITTLE);
+    writer.write_pod(REPLAY_INDEX_MAGIC, Gosu::BO_LITTLE);
+    if (file) file->flush();
+}
+
+ReplayReader::ReplayReader(const std::string& filename)
+    : file(filename), reader(file, 0) {
+    if (file.size() < 16 + REPLAY_FOOTER_SIZE ||
+        reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != REPLAY_MAGIC ||
+        reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != REPLAY_VERSION) {
+        throw std::runtime_error("Not a replay: " + filename);
+    }
+    player_count = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+    keyframe_interval = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+
+    reader.set_position(file.size() - REPLAY_FOOTER_SIZE);
+    tick_count = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+    std::uint64_t index_offset = reader.get_pod<std::uint64_t>(Gosu::BO_LITTLE);
+    if (reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != REPLAY_INDEX_MAGIC ||
+        index_offset >= file.size()) {
+        throw std::runtime_error("Replay has no index (not finished?): " + filename);
+    }
+
+    reader.set_position(static_cast<std::size_t>(index_offset));
+    index.resize(reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE));
+    for (auto& entry : index) {
+        reader.read_pod(entry.first, Gosu::BO_LITTLE);
+        reader.read_pod(entry.second, Gosu::BO_LITTLE);
+    }
+    if (!index.empty()) first_tick = index.front().first;
+    buttons.resize(player_count);
+}
+
+void ReplayReader::seek(World& world, std::uint32_t tick) {
+    if (index.empty() || tick < begin_tick() || tick > end_tick()) {
+        throw std::out_of_range("Tick is not in the replay");
+    }
+    // Last keyframe at or before tick.
+    auto keyframe = std::upper_bound(index.begin(), index.end(), tick,
+        [](std::uint32_t t, const std::pair<std::uint32_t, std::uint64_t>& entry) {
+            return t < entry.first;
+        }) - 1;
+
+    reader.set_position(static_cast<std::size_t>(keyframe->second));
+    if (reader.get_pod<std::uint8_t>() != REPLAY_KEYFRAME || !read_snapshot(reader, world)) {
+        throw std::runtime_error("Replay does not match this world");
+    }
+    reader.read(buttons.data(), buttons.size());
+    while (world.tick < tick) step(world);
+}
+
+void ReplayReader::skip_keyframe(const World& world) {
+    // A written snapshot is exactly as large as the in-memory one; the held buttons follow.
+    reader.seek(snapshot_size(world) + player_count);
+}
+
+void ReplayReader::check_keyframe(const World& world) {
+    // Both are written by write_snapshot, so equal states are equal bytes.
+    Gosu::Buffer expected;
+    Gosu::Writer writer = expected.back_writer();
+    write_snapshot(writer, world);
+    const std::size_t at = reader.position();
+    if (at + expected.size() > file.size() ||
+        std::memcmp(static_cast<const char*>(file.data()) + at, expected.data(), expected.size()) != 0) {
+        throw std::runtime_error("Replay diverges from its keyframe at tick " + std::to_string(world.tick));
+    }
+    reader.seek(expected.size() + player_count);
+}
+
+bool ReplayReader::step(World& world) {
+    if (world.tick >= end_tick()) return false;
+
+    std::uint8_t tag = reader.get_pod<std::uint8_t>();
+    if (tag == REPLAY_KEYFRAME) {
+        if (check_keyframes) check_keyframe(world);
+        else skip_keyframe(world);
+        tag = reader.get_pod<std::uint8_t>();
+    }
+    if (tag != REPLAY_TICK) throw std::runtime_error("Corrupt replay");
+
+    std::uint16_t changes = reader.get_pod<std::uint16_t>(Gosu::BO_LITTLE);
+    for (std::uint16_t i = 0; i < changes; ++i) {
+        std::uint16_t player = reader.get_pod<std::uint16_t>(Gosu::BO_LITTLE);
+        std::uint8_t held = reader.get_pod<std::uint8_t>();
+        if (player < buttons.size()) buttons[player] = held;
+    }
+    world.step(buttons.data());
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "AsyncFile.hpp"
+#include "MappedFile.hpp"
+#include "World.hpp"
+#include <Gosu/IO.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+const std::uint32_t REPLAY_KEYFRAME_INTERVAL = 10 * TICKS_PER_SECOND;
+
+// --- Replay File: per-tick input deltas with a full keyframe every N ticks ---
+// Layout (all values BO_LITTLE):
+//   header   magic "RPLY", version, player count, keyframe interval
+//   records  one per tick: tag REPLAY_TICK, change count (u16), (player u16, buttons u8)...
+//            every keyframe_interval ticks first a tag REPLAY_KEYFRAME record with the
+//            written snapshot (see write_snapshot) and the buttons held by every player
+//   index    keyframe count, then (tick u32, file offset u64) per keyframe
+//   footer   tick count, index offset (u64), magic "RIDX"
+// To reach tick t a reader loads the last keyframe at or before t and re-simulates at most
+// keyframe_interval - 1 ticks, whatever the length of the replay.
+class ReplayWriter {
+    std::unique_ptr<AsyncFile> file;
+    Gosu::Writer writer;
+    std::uint32_t keyframe_interval;
+    std::uint32_t first_tick;
+    std::uint32_t ticks = 0;
+    std::vector<std::uint8_t> last_buttons;
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> index;
+    bool finished = false;
+
+    void write_header();
+
+public:
+    // The world's level must be the one the replay is played back in; only state is stored.
+    // Records into an AsyncFile, so recording never waits for the disk.
+    ReplayWriter(const std::string& filename, const World& world,
+        std::uint32_t keyframe_interval = REPLAY_KEYFRAME_INTERVAL);
+    // Records into any resource, appending at its end.
+    ReplayWriter(Gosu::Resource& sink, const World& world,
+        std::uint32_t keyframe_interval = REPLAY_KEYFRAME_INTERVAL);
+    ~ReplayWriter();
+
+    // Call right before world.step(buttons), with the same buttons.
+    void record(const World& world, const std::uint8_t* buttons);
+
+    // Writes the index (and flushes the file). Called by the destructor if not called before.
+    void finish();
+};
+
+class ReplayReader {
+    MappedFile file;
+    Gosu::Reader reader;
+    std::uint32_t player_count;
+    std::uint32_t keyframe_interval;
+    std::uint32_t tick_count;
+    std::uint32_t first_tick = 0;
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> index;
+    std::vector<std::uint8_t> buttons;
+
+    void skip_keyframe(const World& world);
+    void check_keyframe(const World& world);
+
+public:
+    // If set, step() compares the world with every keyframe it passes and throws
+    // std::runtime_error where they differ, i.e. where playback no longer matches the recording.
+    bool check_keyframes = false;
+
+    explicit ReplayReader(const std::string& filename);
+
+    std::uint32_t players() const { return player_count; }
+    std::uint32_t begin_tick() const { return first_tick; }
+    std::uint32_t end_tick() const { return first_tick + tick_count; }
+
+    // Puts the world into its state at the start of `tick` (begin_tick..end_tick).
+    // The world must contain the replay's level and players() players.
+    void seek(World& world, std::uint32_t tick);
+
+    // Plays the next recorded tick after a seek(). Returns false at the end of the replay.
+    bool step(World& world);
+};
@@ -0,0 +1,85 @@
+#include "Snapshot.hpp"
+#include "SpanIO.hpp"
+#include <cstring>
+#include <type_traits>
+
+std::size_t snapshot_size(const World& world) {
+    std::size_t size = sizeof(SnapshotHeader);
+    World::for_each_field(world, [&](const auto& field) {
+        size += sizeof(field[0]) * field.size();
+    });
+    return size;
+}
+
+void save_snapshot(const World& world, unsigned char* dest) {
+    SnapshotHeader header = { world.tick, static_cast<std::uint32_t>(world.players.size()) };
+    std::memcpy(dest, &header, sizeof header);
+    dest += sizeof header;
+    World::for_each_field(world, [&](const auto& field) {
+        std::size_t bytes = sizeof(field[0]) * field.size();
+        if (bytes) std::memcpy(dest, field.data(), bytes);
+        dest += bytes;
+    });
+}
+
+bool load_snapshot(World& world, const unsigned char* source) {
+    SnapshotHeader header;
+    std::memcpy(&header, source, sizeof header);
+    if (header.player_count != world.players.size()) return false;
+    source += sizeof header;
+
+    world.tick = header.tick;
+    World::for_each_field(world, [&](auto& field) {
+        std::size_t bytes = sizeof(field[0]) * field.size();
+        if (bytes) std::memcpy(field.data(), source, bytes);
+        source += bytes;
+    });
+    world.rebuild_temp_platform_expiry();
+    return true;
+}
+
+void write_snapshot(Gosu::Writer& writer, const World& world) {
+    writer.write_pod(world.tick, Gosu::BO_LITTLE);
+    writer.write_pod(static_cast<std::uint32_t>(world.players.size()), Gosu::BO_LITTLE);
+    World::for_each_field(world, [&](const auto& field) {
+        using T = typename std::decay_t<decltype(field)>::value_type;
+        write_span<T>(writer, field, Gosu::BO_LITTLE);
+    });
+}
+
+bool read_snapshot(Gosu::Reader& reader, World& world) {
+    std::uint32_t tick = reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE);
+    if (reader.get_pod<std::uint32_t>(Gosu::BO_LITTLE) != world.players.size()) return false;
+
+    world.tick = tick;
+    World::for_each_field(world, [&](auto& field) {
+        using T = typename std::decay_t<decltype(field)>::value_type;
+        read_span<T>(reader, field, Gosu::BO_LITTLE);
+    });
+    world.rebuild_temp_platform_expiry();
+    return true;
+}
+
+SnapshotRing::SnapshotRing(std::size_t capacity, const World& world)
+    : storage(capacity * snapshot_size(world)),
+    slot_size(snapshot_size(world)), capacity(capacity) {
+    // Mark every slot empty; tick 0 % capacity could otherwise look valid.
+    for (std::size_t i = 0; i < capacity; ++i) {
+        SnapshotHeader empty = { static_cast<std::uint32_t>(i + 1), 0xffffffff };
+        std::memcpy(&storage[i * slot_size], &empty, sizeof empty);
+    }
+}
+
+void SnapshotRing::save(const World& world) {
+    save_snapshot(world, slot(world.tick));
+}
+
+bool SnapshotRing::contains(std::uint32_t tick) const {
+    SnapshotHeader header;
+    std::memcpy(&header, slot(tick), sizeof header);
+    return header.tick == tick && header.player_count != 0xffffffff;
+}
+
+bool SnapshotRing::restore(World& world, std::uint32_t tick) const {
+    return contains(tick) && load_snapshot(world, slot(tick));
+}
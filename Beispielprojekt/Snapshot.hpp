@@ -0,0 +1,51 @@
+#pragma once
+
+#include "World.hpp"
+#include <Gosu/IO.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- Snapshot: all mutable World state as one flat, trivially copyable block ---
+// Layout: SnapshotHeader, then every array of World::for_each_field, packed.
+// Level geometry is not part of a snapshot; it never changes while playing.
+struct SnapshotHeader {
+    std::uint32_t tick;
+    std::uint32_t player_count;
+};
+
+// Same for all worlds with as many players as this one.
+std::size_t snapshot_size(const World& world);
+
+// dest must hold snapshot_size(world) bytes.
+void save_snapshot(const World& world, unsigned char* dest);
+
+// The world must already have as many players as the snapshot; nothing is allocated.
+// Returns false (and leaves the world untouched) if the player count differs.
+bool load_snapshot(World& world, const unsigned char* source);
+
+// Portable form of a snapshot for files: same layout, every value written BO_LITTLE.
+void write_snapshot(Gosu::Writer& writer, const World& world);
+bool read_snapshot(Gosu::Reader& reader, World& world);
+
+// --- Snapshot Ring: the last `capacity` ticks, preallocated once ---
+class SnapshotRing {
+    std::vector<unsigned char> storage;
+    std::size_t slot_size;
+    std::size_t capacity;
+
+    unsigned char* slot(std::uint32_t tick) { return &storage[(tick % capacity) * slot_size]; }
+    const unsigned char* slot(std::uint32_t tick) const { return &storage[(tick % capacity) * slot_size]; }
+
+public:
+    // Sized for worlds with as many players as world.
+    SnapshotRing(std::size_t capacity, const World& world);
+
+    // Stores the world under its current tick, overwriting the tick `capacity` ago.
+    void save(const World& world);
+
+    bool contains(std::uint32_t tick) const;
+
+    // Rewinds the world to a saved tick. Returns false if that tick is no longer stored.
+    bool restore(World& world, std::uint32_t tick) const;
+};
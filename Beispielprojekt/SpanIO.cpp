@@ -0,0 +1,97 @@
+#include "SpanIO.hpp"
+#include "AssetPack.hpp"
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define SPAN_IO_SSSE3
+#define SPAN_IO_SIMD
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SPAN_IO_SIMD
+#endif
+
+#if defined(_MSC_VER)
+#include <stdlib.h>
+static std::uint16_t swapped(std::uint16_t v) { return _byteswap_ushort(v); }
+static std::uint32_t swapped(std::uint32_t v) { return _byteswap_ulong(v); }
+static std::uint64_t swapped(std::uint64_t v) { return _byteswap_uint64(v); }
+#else
+static std::uint16_t swapped(std::uint16_t v) { return __builtin_bswap16(v); }
+static std::uint32_t swapped(std::uint32_t v) { return __builtin_bswap32(v); }
+static std::uint64_t swapped(std::uint64_t v) { return __builtin_bswap64(v); }
+#endif
+
+template<typename U>
+static void copy_swapped_scalar(const unsigned char* source, unsigned char* dest, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        U v;
+        std::memcpy(&v, source + i * sizeof(U), sizeof(U));
+        v = swapped(v);
+        std::memcpy(dest + i * sizeof(U), &v, sizeof(U));
+    }
+}
+
+void copy_swapped(const void* source, void* dest, std::size_t count, std::size_t width) {
+    const unsigned char* in = static_cast<const unsigned char*>(source);
+    unsigned char* out = static_cast<unsigned char*>(dest);
+
+#ifdef SPAN_IO_SIMD
+    // 16 bytes at a time: 8 shorts, 4 ints or 2 doubles.
+#ifdef SPAN_IO_SSSE3
+    __m128i mask;
+    switch (width) {
+    case 2: mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14); break;
+    case 4: mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12); break;
+    default: mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8); break;
+    }
+    auto swap_vector = [&](__m128i v) { return _mm_shuffle_epi8(v, mask); };
+#else
+    // SSE2 has no byte shuffle: reverse the 16-bit words of each value, then the two bytes
+    // of each word.
+    auto swap_vector = [&](__m128i v) {
+        if (width == 4) {
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        }
+        else if (width == 8) {
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+        }
+        return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    };
+#endif
+    if (width == 2 || width == 4 || width == 8) {
+        const std::size_t per_vector = 16 / width;
+        const std::size_t vectors = count / per_vector;
+        for (std::size_t i = 0; i < vectors; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16 * i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * i), swap_vector(v));
+        }
+        in += 16 * vectors;
+        out += 16 * vectors;
+        count -= vectors * per_vector;
+    }
+#endif
+
+    switch (width) {
+    case 2: copy_swapped_scalar<std::uint16_t>(in, out, count); break;
+    case 4: copy_swapped_scalar<std::uint32_t>(in, out, count); break;
+    case 8: copy_swapped_scalar<std::uint64_t>(in, out, count); break;
+    default: if (in != out) std::memcpy(out, in, count * width); break;
+    }
+}
+
+const unsigned char* contiguous_data(const Gosu::Resource& resource) {
+    if (resource.size() == 0) return nullptr;
+    if (auto buffer = dynamic_cast<const Gosu::Buffer*>(&resource)) {
+        return static_cast<const unsigned char*>(buffer->data());
+    }
+    if (auto mapped = dynamic_cast<const MappedFile*>(&resource)) {
+        return static_cast<const unsigned char*>(mapped->data());
+    }
+    if (auto entry = dynamic_cast<const PackEntry*>(&resource)) {
+        return static_cast<const unsigned char*>(entry->data());
+    }
+    return nullptr;
+}
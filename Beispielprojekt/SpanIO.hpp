@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Gosu/IO.hpp>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+// --- Span IO: bulk versions of Gosu::Reader::read_pod / Gosu::Writer::write_pod ---
+// A whole array costs one Resource::read (or none, for memory-backed resources) plus one
+// byte swapping pass, instead of one virtual call and one std::reverse per element.
+
+// Copies count elements of width 2, 4 or 8 bytes from source to dest, reversing the bytes of
+// each. source and dest may be the same pointer. 16 bytes at a time with SSE2 (every x64
+// build) or, where the compiler may use them, SSSE3 byte shuffles.
+void copy_swapped(const void* source, void* dest, std::size_t count, std::size_t width);
+
+// Returns the bytes of a resource that lives in memory (Gosu::Buffer, MappedFile, PackEntry),
+// or nullptr if it can only be accessed through Resource::read.
+const unsigned char* contiguous_data(const Gosu::Resource& resource);
+
+template<typename T>
+void read_span(Gosu::Reader& reader, std::span<T> values, Gosu::ByteOrder bo = Gosu::BO_DONT_CARE) {
+    static_assert(std::is_trivially_copyable_v<T>, "read_span needs plain data");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+        "read_span can only swap 1, 2, 4 or 8 byte values");
+    if (values.empty()) return;
+
+    const bool swap = bo == Gosu::BO_OTHER && sizeof(T) > 1;
+    const unsigned char* memory = contiguous_data(reader.resource());
+    if (memory && reader.position() + values.size_bytes() <= reader.resource().size()) {
+        const unsigned char* source = memory + reader.position();
+        if (swap) copy_swapped(source, values.data(), values.size(), sizeof(T));
+        else std::memcpy(values.data(), source, values.size_bytes());
+        reader.seek(static_cast<std::ptrdiff_t>(values.size_bytes()));
+        return;
+    }
+    reader.read(values.data(), values.size_bytes());
+    if (swap) copy_swapped(values.data(), values.data(), values.size(), sizeof(T));
+}
+
+template<typename T>
+void write_span(Gosu::Writer& writer, std::span<const T> values, Gosu::ByteOrder bo = Gosu::BO_DONT_CARE) {
+    static_assert(std::is_trivially_copyable_v<T>, "write_span needs plain data");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+        "write_span can only swap 1, 2, 4 or 8 byte values");
+    if (values.empty()) return;
+
+    if (bo != Gosu::BO_OTHER || sizeof(T) == 1) {
+        writer.write(values.data(), values.size_bytes());
+        return;
+    }
+    // Swap through a small stack buffer, so the source stays untouched and nothing is allocated.
+    alignas(16) unsigned char chunk[4096];
+    const std::size_t per_chunk = sizeof chunk / sizeof(T);
+    for (std::size_t i = 0; i < values.size(); i += per_chunk) {
+        std::size_t count = values.size() - i < per_chunk ? values.size() - i : per_chunk;
+        copy_swapped(values.data() + i, chunk, count, sizeof(T));
+        writer.write(chunk, count * sizeof(T));
+    }
+}
@@ -0,0 +1,128 @@
+#include "TextCache.hpp"
+#include <Gosu/ImageData.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Decodes the codepoint starting at text[i] and moves i past it. Malformed UTF-8 comes out
+// as U+FFFD, one replacement per bad sequence.
+static char32_t next_codepoint(std::string_view text, std::size_t& i) {
+    unsigned char lead = static_cast<unsigned char>(text[i++]);
+    if (lead < 0x80) return lead;
+    int extra = lead >= 0xf8 ? -1 : lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : lead >= 0xc0 ? 1 : -1;
+    if (extra < 0) return 0xfffd;
+    char32_t codepoint = lead & (0x3f >> extra);
+    for (int k = 0; k < extra; ++k) {
+        if (i >= text.size() || (static_cast<unsigned char>(text[i]) & 0xc0) != 0x80) return 0xfffd;
+        codepoint = codepoint << 6 | (static_cast<unsigned char>(text[i++]) & 0x3f);
+    }
+    return codepoint;
+}
+
+// --- Glyph Atlas ---
+
+GlyphAtlas::GlyphAtlas(double font_height, const std::string& font_name, unsigned font_flags)
+    : font_name(font_name), font_height(font_height), font_flags(font_flags),
+    cell_height(static_cast<int>(std::ceil(font_height))) {
+    if (cell_height <= 0 || cell_height + 2 > GLYPH_ATLAS_PAGE_SIZE) {
+        throw std::invalid_argument("Font height does not fit into a glyph atlas page");
+    }
+    ascii.fill(-1);
+}
+
+GlyphAtlas::Glyph GlyphAtlas::rasterize(char32_t codepoint) {
+    const std::u32string text(1, codepoint);
+    Glyph glyph = { Gosu::Image(), Gosu::text_width(text, font_name, font_height, font_flags) };
+    const int width = static_cast<int>(std::ceil(glyph.advance));
+    if (width <= 0) return glyph;
+    if (width + 2 > GLYPH_ATLAS_PAGE_SIZE) throw std::invalid_argument("Glyph too wide for the glyph atlas");
+
+    // Shelves of cell_height rows, filled left to right, with a transparent pixel between
+    // glyphs so smooth filtering never picks up a neighbour.
+    if (!pages.empty() && shelf_x + width + 1 > GLYPH_ATLAS_PAGE_SIZE) {
+        shelf_x = 1;
+        shelf_y += cell_height + 1;
+    }
+    if (pages.empty() || shelf_y + cell_height + 1 > GLYPH_ATLAS_PAGE_SIZE) {
+        pages.emplace_back(Gosu::Bitmap(GLYPH_ATLAS_PAGE_SIZE, GLYPH_ATLAS_PAGE_SIZE));
+        shelf_x = 1;
+        shelf_y = 1;
+    }
+
+    Gosu::Bitmap pixels(width, cell_height);
+    Gosu::draw_text(pixels, 0, 0, Gosu::Color::WHITE, text, font_name, font_height, font_flags);
+    Gosu::ImageData& page = pages.back().data();
+    page.insert(pixels, shelf_x, shelf_y);
+    glyph.image = Gosu::Image(page.subimage(shelf_x, shelf_y, width, cell_height));
+    shelf_x += width + 1;
+    return glyph;
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::glyph(char32_t codepoint) {
+    if (codepoint < ascii.size()) {
+        std::int32_t& index = ascii[codepoint];
+        if (index < 0) {
+            glyphs.push_back(rasterize(codepoint));
+            index = static_cast<std::int32_t>(glyphs.size() - 1);
+        }
+        return glyphs[index];
+    }
+    auto it = other.find(codepoint);
+    if (it == other.end()) {
+        glyphs.push_back(rasterize(codepoint));
+        it = other.emplace(codepoint, glyphs.size() - 1).first;
+    }
+    return glyphs[it->second];
+}
+
+void GlyphAtlas::prepare(std::string_view text) {
+    for (std::size_t i = 0; i < text.size();) glyph(next_codepoint(text, i));
+}
+
+double GlyphAtlas::text_width(std::string_view text) {
+    double width = 0;
+    for (std::size_t i = 0; i < text.size();) width += glyph(next_codepoint(text, i)).advance;
+    return width;
+}
+
+double GlyphAtlas::draw_text(std::string_view text, double x, double y, Gosu::ZPos z,
+    double scale_x, double scale_y, Gosu::Color c, Gosu::BlendMode mode) {
+    double pen = x;
+    for (std::size_t i = 0; i < text.size();) {
+        const Glyph& g = glyph(next_codepoint(text, i));
+        if (g.image.width() > 0) {
+            g.image.draw(pen, y, z, scale_x, scale_y, c, mode);
+            ++quads;
+        }
+        pen += g.advance * scale_x;
+    }
+    return pen - x;
+}
+
+// --- Text Layout Cache ---
+
+TextLayoutCache::TextLayoutCache(std::size_t capacity, double font_height, const std::string& font_name,
+    bool markup, double line_spacing, int width, Gosu::Alignment align, unsigned font_flags)
+    : capacity(std::max<std::size_t>(capacity, 1)), font_name(font_name), font_height(font_height),
+    line_spacing(line_spacing), width(width), align(align), font_flags(font_flags), markup(markup) {
+}
+
+const Gosu::Image& TextLayoutCache::image(const std::string& text) {
+    auto found = lookup.find(std::string_view(text));
+    if (found != lookup.end()) {
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->image;
+    }
+
+    Gosu::Bitmap bitmap = markup
+        ? Gosu::layout_markup(text, font_name, font_height, line_spacing, width, align, font_flags)
+        : Gosu::layout_text(text, font_name, font_height, line_spacing, width, align, font_flags);
+    entries.push_front(Entry{ text, Gosu::Image(bitmap) });
+    // The key views the string inside the list node, which never moves.
+    lookup.emplace(entries.front().text, entries.begin());
+    if (entries.size() > capacity) {
+        lookup.erase(entries.back().text);
+        entries.pop_back();
+    }
+    return entries.front().image;
+}
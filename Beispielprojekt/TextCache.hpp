@@ -0,0 +1,99 @@
+#pragma once
+
+#include <Gosu/Bitmap.hpp>
+#include <Gosu/Color.hpp>
+#include <Gosu/GraphicsBase.hpp>
+#include <Gosu/Image.hpp>
+#include <Gosu/Text.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+const int GLYPH_ATLAS_PAGE_SIZE = 512;
+
+// --- Glyph Atlas: single-line text drawn as one quad per glyph from shared textures ---
+// Each codepoint is rasterized once with Gosu::draw_text into a GLYPH_ATLAS_PAGE_SIZE page
+// and kept as a sub-image of it, so all glyphs of a page share one texture and Gosu can
+// batch them. Drawing a string only looks glyphs up; a timer that changes every frame never
+// rasterizes anything after its ten digits have been seen once.
+// Glyphs are placed by their own advance, without kerning between pairs.
+class GlyphAtlas {
+    struct Glyph {
+        Gosu::Image image; // empty for glyphs without pixels, e.g. spaces
+        double advance;
+    };
+
+    std::string font_name;
+    double font_height;
+    unsigned font_flags;
+    int cell_height;
+
+    std::vector<Gosu::Image> pages;
+    int shelf_x = 0, shelf_y = 0;
+
+    std::vector<Glyph> glyphs;
+    std::array<std::int32_t, 128> ascii; // index into glyphs, or -1
+    std::unordered_map<char32_t, std::size_t> other;
+    std::size_t quads = 0;
+
+    const Glyph& glyph(char32_t codepoint);
+    Glyph rasterize(char32_t codepoint);
+
+public:
+    explicit GlyphAtlas(double font_height, const std::string& font_name = Gosu::default_font_name(),
+        unsigned font_flags = 0);
+
+    double height() const { return font_height; }
+
+    // Rasterizes every glyph of text now, e.g. "0123456789:." before the first frame.
+    void prepare(std::string_view text);
+
+    // text is UTF-8; line breaks are not handled. Neither function allocates once every
+    // glyph of the text has been drawn or measured before.
+    double text_width(std::string_view text);
+    // Returns the width of the drawn text.
+    double draw_text(std::string_view text, double x, double y, Gosu::ZPos z,
+        double scale_x = 1, double scale_y = 1, Gosu::Color c = Gosu::Color::WHITE,
+        Gosu::BlendMode mode = Gosu::BM_DEFAULT);
+
+    // Glyph quads drawn so far, for draw call statistics.
+    std::size_t quads_drawn() const { return quads; }
+    std::size_t glyph_count() const { return glyphs.size(); }
+    std::size_t page_count() const { return pages.size(); }
+};
+
+// --- Text Layout Cache: the last few results of Gosu::layout_text / layout_markup ---
+// For multi-line or markup text that is drawn again and again, e.g. a help screen: the
+// first request lays the text out into an image, repeated ones are a hash lookup.
+class TextLayoutCache {
+    struct Entry {
+        std::string text;
+        Gosu::Image image;
+    };
+
+    std::size_t capacity;
+    std::string font_name;
+    double font_height, line_spacing;
+    int width;
+    Gosu::Alignment align;
+    unsigned font_flags;
+    bool markup;
+
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> lookup;
+
+public:
+    // Same parameters as Gosu::layout_text; markup chooses layout_markup instead.
+    TextLayoutCache(std::size_t capacity, double font_height,
+        const std::string& font_name = Gosu::default_font_name(), bool markup = false,
+        double line_spacing = 0, int width = -1, Gosu::Alignment align = Gosu::AL_LEFT,
+        unsigned font_flags = 0);
+
+    // The image stays valid until capacity other texts have been requested.
+    const Gosu::Image& image(const std::string& text);
+};
@@ -0,0 +1,126 @@
+#include "TileMap.hpp"
+#include <Gosu/Graphics.hpp>
+#include <Gosu/IO.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+TileMap::TileMap(int columns, int rows, const std::vector<std::uint16_t>& cells)
+    : column_count(columns), row_count(rows), words_per_row((static_cast<std::size_t>(columns) + 63) / 64) {
+    if (columns <= 0 || rows <= 0 || cells.size() != static_cast<std::size_t>(columns) * rows) {
+        throw std::invalid_argument("Tile map size does not match its cells");
+    }
+    auto cell = [&](int c, int r) { return cells[static_cast<std::size_t>(r) * columns + c]; };
+
+    row_begin.reserve(static_cast<std::size_t>(rows) + 1);
+    surface.resize(words_per_row * rows);
+    for (int r = 0; r < rows; ++r) {
+        row_begin.push_back(static_cast<std::uint32_t>(runs.size()));
+        for (int c = 0; c < columns; ++c) {
+            const std::uint16_t tile = cell(c, r);
+            if (tile == 0) continue;
+
+            const bool open_above = r == 0 || cell(c, r - 1) == 0;
+            if (open_above) surface[r * words_per_row + c / 64] |= std::uint64_t(1) << (c % 64);
+
+            TileRun* last = runs.size() > row_begin.back() ? &runs.back() : nullptr;
+            if (last && last->start + last->length == static_cast<std::uint32_t>(c) &&
+                last->tile == tile - 1 && last->length < std::numeric_limits<std::uint16_t>::max()) {
+                ++last->length;
+            }
+            else {
+                runs.push_back(TileRun{ static_cast<std::uint32_t>(c), 1, static_cast<std::uint16_t>(tile - 1) });
+            }
+        }
+    }
+    row_begin.push_back(static_cast<std::uint32_t>(runs.size()));
+    runs.shrink_to_fit();
+}
+
+std::span<const TileRun> TileMap::row(int r) const {
+    return std::span<const TileRun>(runs.data() + row_begin[r], row_begin[r + 1] - row_begin[r]);
+}
+
+bool TileMap::surface_in_row(int r, int first, int last) const {
+    if (r < 0 || r >= row_count) return false;
+    first = std::max(first, 0);
+    last = std::min(last, column_count - 1);
+    if (first > last) return false;
+
+    const std::uint64_t* bits = &surface[r * words_per_row];
+    const std::size_t first_word = first / 64, last_word = last / 64;
+    const std::uint64_t first_mask = ~std::uint64_t(0) << (first % 64);
+    const std::uint64_t last_mask = ~std::uint64_t(0) >> (63 - last % 64);
+    if (first_word == last_word) return (bits[first_word] & first_mask & last_mask) != 0;
+    if (bits[first_word] & first_mask) return true;
+    for (std::size_t w = first_word + 1; w < last_word; ++w) {
+        if (bits[w]) return true;
+    }
+    return (bits[last_word] & last_mask) != 0;
+}
+
+std::uint32_t TileMap::draw(const std::vector<Gosu::Image>& tileset, double left, double top,
+    double right, double bottom, Gosu::ZPos z, Gosu::Color color) const {
+    const int first_row = std::max(0, static_cast<int>(top / TILE_SIZE));
+    const int last_row = std::min(row_count - 1, static_cast<int>(bottom / TILE_SIZE));
+    const std::uint32_t first_column = static_cast<std::uint32_t>(std::max(0.0, left / TILE_SIZE));
+    const std::uint32_t last_column = static_cast<std::uint32_t>(std::max(0.0, right / TILE_SIZE));
+    std::uint32_t quads = 0;
+
+    for (int r = first_row; r <= last_row; ++r) {
+        const std::span<const TileRun> row_runs = row(r);
+        // First run that reaches into the view.
+        auto run = std::partition_point(row_runs.begin(), row_runs.end(),
+            [&](const TileRun& run) { return run.start + run.length <= first_column; });
+        const double y = static_cast<double>(r) * TILE_SIZE;
+
+        for (; run != row_runs.end() && run->start <= last_column; ++run) {
+            const std::uint32_t begin = std::max(run->start, first_column);
+            const std::uint32_t end = std::min<std::uint32_t>(run->start + run->length, last_column + 1);
+            if (run->tile >= tileset.size()) {
+                Gosu::Graphics::draw_rect(static_cast<double>(begin) * TILE_SIZE, y,
+                    static_cast<double>(end - begin) * TILE_SIZE, TILE_SIZE, color, z);
+                ++quads;
+                continue;
+            }
+            const Gosu::Image& image = tileset[run->tile];
+            for (std::uint32_t c = begin; c < end; ++c) {
+                image.draw(static_cast<double>(c) * TILE_SIZE, y, z);
+            }
+            quads += end - begin;
+        }
+    }
+    return quads;
+}
+
+TileMap load_tile_map(const std::string& filename) {
+    Gosu::File file(filename);
+    std::string text(file.size(), '\0');
+    file.read(0, text.size(), text.data());
+
+    std::vector<std::string> lines;
+    std::size_t width = 0;
+    for (std::size_t begin = 0; begin < text.size();) {
+        std::size_t end = text.find('\n', begin);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(begin, end - begin);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        width = std::max(width, line.size());
+        lines.push_back(std::move(line));
+        begin = end + 1;
+    }
+
+    const char* const digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+    std::vector<std::uint16_t> cells(width * lines.size(), 0);
+    for (std::size_t r = 0; r < lines.size(); ++r) {
+        for (std::size_t c = 0; c < lines[r].size(); ++c) {
+            const char ch = lines[r][c];
+            if (ch == '.' || ch == ' ') continue;
+            const char* digit = ch ? std::strchr(digits, ch) : nullptr;
+            if (!digit) throw std::runtime_error("Unknown tile '" + std::string(1, ch) + "' in " + filename);
+            cells[r * width + c] = static_cast<std::uint16_t>(digit - digits + 1);
+        }
+    }
+    return TileMap(static_cast<int>(width), static_cast<int>(lines.size()), cells);
+}
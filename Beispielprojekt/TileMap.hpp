@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Gosu/Color.hpp>
+#include <Gosu/GraphicsBase.hpp>
+#include <Gosu/Image.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+const int TILE_SIZE = 32;
+
+// --- Tile Run: `length` cells of one tile, starting at column `start` ---
+struct TileRun {
+    std::uint32_t start;
+    std::uint16_t length;
+    std::uint16_t tile; // index into the tileset
+};
+
+// --- Tile Map: an optional grid layer of TILE_SIZE tiles over the level ---
+// Every row is kept as its runs of equal tiles, with the empty cells in between left out,
+// so a large level that is mostly air costs little memory. Drawing only visits the runs of
+// the visible rows. For collision each row also has a bitset of the cells that form a top
+// surface: solid with no solid cell right above. Like platforms, tiles only carry players
+// from above; a landing test for a row is a couple of masked word compares.
+class TileMap {
+    int column_count, row_count;
+    std::size_t words_per_row;
+    std::vector<std::uint32_t> row_begin; // row r's runs are runs[row_begin[r], row_begin[r + 1])
+    std::vector<TileRun> runs;
+    std::vector<std::uint64_t> surface;
+
+public:
+    // cells holds columns * rows tile numbers, row by row: 0 is empty, n is tileset[n - 1].
+    TileMap(int columns, int rows, const std::vector<std::uint16_t>& cells);
+
+    int columns() const { return column_count; }
+    int rows() const { return row_count; }
+    double width() const { return column_count * static_cast<double>(TILE_SIZE); }
+    double height() const { return row_count * static_cast<double>(TILE_SIZE); }
+    std::size_t run_count() const { return runs.size(); }
+
+    std::span<const TileRun> row(int r) const;
+
+    // True if a cell of columns first to last in row r has its top edge free to stand on.
+    // Columns outside the map are ignored.
+    bool surface_in_row(int r, int first, int last) const;
+
+    // Draws the tiles inside the given area, one tileset image per tile. Without a tileset,
+    // every run is one rectangle of `color`. Returns the number of quads drawn.
+    std::uint32_t draw(const std::vector<Gosu::Image>& tileset, double left, double top,
+        double right, double bottom, Gosu::ZPos z, Gosu::Color color = Gosu::Color::GRAY) const;
+};
+
+// Reads a tile map from a text file: one line per row, '.' or ' ' for an empty cell, and
+// '0'-'9', 'a'-'z' for tiles 0 to 35 of the tileset. Shorter lines are padded with air.
+TileMap load_tile_map(const std::string& filename);
@@ -0,0 +1,64 @@
+#include "TimerWheel.hpp"
+
+TimerWheel::TimerWheel(std::uint32_t now) : now(now) {
+    heads.fill(TIMER_WHEEL_NONE);
+}
+
+void TimerWheel::reserve(std::size_t capacity) {
+    if (capacity <= due.size()) return;
+    next.resize(capacity, TIMER_WHEEL_NONE);
+    prev.resize(capacity, TIMER_WHEEL_NONE);
+    due.resize(capacity, 0);
+    bucket.resize(capacity, TIMER_WHEEL_NONE);
+}
+
+void TimerWheel::reset(std::uint32_t tick) {
+    heads.fill(TIMER_WHEEL_NONE);
+    for (std::uint32_t& b : bucket) b = TIMER_WHEEL_NONE;
+    now = tick;
+}
+
+void TimerWheel::link(std::uint32_t id) {
+    // The coarsest level the timer has to wait on; 0 if it is due within this block of ticks.
+    const std::uint32_t delta = due[id] - now;
+    std::uint32_t level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVELS && delta >= 1u << (TIMER_WHEEL_BITS * (level + 1))) ++level;
+    const std::uint32_t slot = (due[id] >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+
+    const std::uint32_t b = level * TIMER_WHEEL_SLOTS + slot;
+    bucket[id] = b;
+    prev[id] = TIMER_WHEEL_NONE;
+    next[id] = heads[b];
+    if (heads[b] != TIMER_WHEEL_NONE) prev[heads[b]] = id;
+    heads[b] = id;
+}
+
+void TimerWheel::unlink(std::uint32_t id) {
+    if (prev[id] != TIMER_WHEEL_NONE) next[prev[id]] = next[id];
+    else heads[bucket[id]] = next[id];
+    if (next[id] != TIMER_WHEEL_NONE) prev[next[id]] = prev[id];
+    bucket[id] = TIMER_WHEEL_NONE;
+}
+
+void TimerWheel::cascade(std::uint32_t level) {
+    // Every timer of this slot is due within the block that starts now; re-linking moves it
+    // to a finer level.
+    const std::uint32_t slot = (now >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    std::uint32_t id = heads[level * TIMER_WHEEL_SLOTS + slot];
+    heads[level * TIMER_WHEEL_SLOTS + slot] = TIMER_WHEEL_NONE;
+    while (id != TIMER_WHEEL_NONE) {
+        const std::uint32_t following = next[id];
+        link(id);
+        id = following;
+    }
+}
+
+void TimerWheel::schedule(std::uint32_t id, std::uint32_t tick) {
+    if (scheduled(id)) unlink(id);
+    due[id] = tick;
+    link(id);
+}
+
+void TimerWheel::cancel(std::uint32_t id) {
+    if (scheduled(id)) unlink(id);
+}
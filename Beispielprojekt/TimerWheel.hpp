@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const std::uint32_t TIMER_WHEEL_BITS = 8;
+const std::uint32_t TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_BITS;
+const std::uint32_t TIMER_WHEEL_LEVELS = 4; // 4 x 8 bits: any tick in the 32-bit range
+const std::uint32_t TIMER_WHEEL_NONE = 0xffffffff;
+
+// --- Timer Wheel: hierarchical wheel of expiry ticks for ids 0 to capacity - 1 ---
+// A timer due within 256 ticks waits in the slot of its tick on level 0. Later timers wait
+// on a coarser level, in the slot for their 256^level block of ticks. When the clock
+// reaches such a block, that slot is moved one level down. Advancing by one tick touches
+// one level-0 slot and, every 256 ticks, one slot of a coarser level, however many timers
+// are waiting. So the cost of expiry is the number of timers that expire.
+// Timers are intrusive lists over per-id arrays, so scheduling never allocates.
+class TimerWheel {
+    std::vector<std::uint32_t> next, prev, due;
+    std::vector<std::uint32_t> bucket; // level * TIMER_WHEEL_SLOTS + slot, or TIMER_WHEEL_NONE
+    std::array<std::uint32_t, TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS> heads;
+    std::uint32_t now;
+
+    void link(std::uint32_t id);
+    void unlink(std::uint32_t id);
+    void cascade(std::uint32_t level);
+
+public:
+    // now is the last tick that counts as processed.
+    explicit TimerWheel(std::uint32_t now = 0);
+
+    std::size_t capacity() const { return due.size(); }
+    void reserve(std::size_t capacity);
+
+    // Cancels all timers and sets the clock.
+    void reset(std::uint32_t now);
+    std::uint32_t current_tick() const { return now; }
+
+    // Schedules (or reschedules) id to expire at tick, which must be after current_tick().
+    void schedule(std::uint32_t id, std::uint32_t tick);
+    void cancel(std::uint32_t id);
+    bool scheduled(std::uint32_t id) const { return bucket[id] != TIMER_WHEEL_NONE; }
+
+    // Moves the clock forward to tick and calls expired(id) for every timer due on the way,
+    // tick by tick. Within one tick the order of the calls is unspecified.
+    template<typename F>
+    void advance(std::uint32_t tick, F&& expired) {
+        while (now != tick) {
+            ++now;
+            for (std::uint32_t level = TIMER_WHEEL_LEVELS - 1; level > 0; --level) {
+                if ((now & ((1u << (TIMER_WHEEL_BITS * level)) - 1)) == 0) cascade(level);
+            }
+            std::uint32_t& head = heads[now & (TIMER_WHEEL_SLOTS - 1)];
+            while (head != TIMER_WHEEL_NONE) {
+                const std::uint32_t id = head;
+                unlink(id);
+                expired(id);
+            }
+        }
+    }
+};
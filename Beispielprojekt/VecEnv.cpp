@@ -0,0 +1,266 @@
+#include "VecEnv.hpp"
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+    // The N nearest of the objects offered so far, nearest first.
+    template<std::size_t N, std::size_t Fields>
+    struct Nearest {
+        std::array<double, N> distance;
+        std::array<std::array<float, Fields>, N> values;
+        std::size_t count = 0;
+
+        void offer(double d, const std::array<float, Fields>& v) {
+            if (count == N && d >= distance[N - 1]) return;
+            std::size_t i = count < N ? count++ : N - 1;
+            for (; i > 0 && distance[i - 1] > d; --i) {
+                distance[i] = distance[i - 1];
+                values[i] = values[i - 1];
+            }
+            distance[i] = d;
+            values[i] = v;
+        }
+
+        float* write(float* out) const {
+            for (std::size_t i = 0; i < N; ++i) {
+                for (std::size_t f = 0; f < Fields; ++f) *out++ = i < count ? values[i][f] : 0.0f;
+            }
+            return out;
+        }
+    };
+
+    // Squared distance from (cx, cy) to the nearest point of a rectangle.
+    double distance_to(double cx, double cy, double x, double y, double w, double h) {
+        const double dx = std::max({ x - cx, 0.0, cx - (x + w) });
+        const double dy = std::max({ y - cy, 0.0, cy - (y + h) });
+        return dx * dx + dy * dy;
+    }
+}
+
+VecEnv::VecEnv(const LevelData* level, std::size_t envs, const EnvConfig& config, unsigned threads)
+    : config(config),
+      spawn_x(level ? level->spawn_x : LEVEL_SPAWN_X),
+      spawn_y(level ? level->spawn_y : LEVEL_SPAWN_Y) {
+    if (envs == 0) throw std::invalid_argument("VecEnv needs at least one environment");
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // At least one shard per thread, as long as there are enough environments.
+    const std::size_t shard_size = std::min(ENV_SHARD_SIZE, (envs + threads - 1) / threads);
+    for (std::size_t begin = 0; begin < envs; begin += shard_size) {
+        Shard shard;
+        shard.world = std::make_unique<World>(0, 0);
+        if (level) build_level(*shard.world, *level);
+        else build_default_level(*shard.world);
+        for (std::size_t e = begin; e < std::min(envs, begin + shard_size); ++e) shard.world->add_player(spawn_x, spawn_y);
+        shard.begin = begin;
+        shards.push_back(std::move(shard));
+    }
+    index_level(*shards.front().world);
+
+    best_x.resize(envs);
+    episode_ticks.resize(envs);
+    observations.resize(envs * ENV_OBSERVATION_SIZE);
+    rewards.resize(envs);
+    terminated.resize(envs);
+    truncated.resize(envs);
+
+    for (std::size_t t = 1; t < std::min<std::size_t>(threads, shards.size()); ++t) {
+        workers.emplace_back(&VecEnv::worker_loop, this);
+    }
+    reset();
+}
+
+VecEnv::~VecEnv() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void VecEnv::index_level(const World& world) {
+    std::vector<std::size_t> order(world.geometry.platforms.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return world.geometry.platforms[a]->x < world.geometry.platforms[b]->x; });
+    for (std::size_t k : order) {
+        const Platform& platform = *world.geometry.platforms[k];
+        platform_x.push_back(platform.x);
+        platform_y.push_back(platform.y);
+        platform_width.push_back(platform.width);
+        platform_height.push_back(platform.height);
+        widest_platform = std::max(widest_platform, platform.width);
+    }
+
+    order.resize(world.geometry.obstacles.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return world.geometry.obstacles[a]->x < world.geometry.obstacles[b]->x; });
+    for (std::size_t k : order) {
+        const Obstacle& obstacle = *world.geometry.obstacles[k];
+        obstacle_x.push_back(obstacle.x);
+        obstacle_y.push_back(obstacle.y);
+        obstacle_size.push_back(obstacle.width);
+        largest_obstacle = std::max(largest_obstacle, obstacle.width);
+    }
+}
+
+void VecEnv::index_temp_platforms(Shard& shard) const {
+    // Counting sort by owner.
+    const World& world = *shard.world;
+    const TempPlatforms& temp = world.temp_platforms.columns;
+    const std::size_t n = world.players.size();
+    shard.temp_begin.assign(n + 1, 0);
+    for (std::size_t k = 0; k < world.temp_platforms.size(); ++k) ++shard.temp_begin[temp.owner[k] + 1];
+    for (std::size_t i = 0; i < n; ++i) shard.temp_begin[i + 1] += shard.temp_begin[i];
+    shard.temp_order.resize(world.temp_platforms.size());
+    for (std::size_t k = 0; k < world.temp_platforms.size(); ++k) {
+        shard.temp_order[shard.temp_begin[temp.owner[k]]++] = static_cast<std::uint32_t>(k);
+    }
+    // Every begin has moved on to the next one's; move them back.
+    for (std::size_t i = n; i > 0; --i) shard.temp_begin[i] = shard.temp_begin[i - 1];
+    shard.temp_begin[0] = 0;
+}
+
+void VecEnv::observe(const Shard& shard, std::size_t i, float* out) const {
+    const World& world = *shard.world;
+    const Players& p = world.players;
+    const TempPlatformRules& rules = world.temp_platform_rules;
+    const std::uint32_t since = world.tick - p.temp_platform_last_placed[i];
+    const double cooldown = p.temp_platform_count[i] >= rules.per_player ? 1.0
+        : since >= rules.cooldown ? 0.0 : static_cast<double>(rules.cooldown - since) / rules.cooldown;
+
+    const double x = p.x[i], y = p.y[i];
+    for (double field : { x / world.width, y / world.height, p.velocity_x[i] / MOVE_SPEED, p.velocity_y[i] / -JUMP_STRENGTH,
+        static_cast<double>(p.on_ground[i]), static_cast<double>(p.jumps_available[i]) / MAX_JUMPS,
+        static_cast<double>(p.jump_in_progress[i]), cooldown }) {
+        *out++ = static_cast<float>(field);
+    }
+
+    const double cx = x + PLAYER_SIZE / 2, cy = y + PLAYER_SIZE / 2;
+    const double scale = 1 / ENV_VIEW;
+    auto in_view = [&](double ox, double oy, double ow, double oh) {
+        return ox < cx + ENV_VIEW && ox + ow > cx - ENV_VIEW && oy < cy + ENV_VIEW && oy + oh > cy - ENV_VIEW;
+    };
+    auto relative = [&](double ox, double oy, double ow, double oh) {
+        return std::array<float, 4>{ static_cast<float>((ox - x) * scale), static_cast<float>((oy - y) * scale),
+            static_cast<float>(ow * scale), static_cast<float>(oh * scale) };
+    };
+
+    // Anything starting further left than this ends before the view.
+    Nearest<ENV_PLATFORMS, 4> platforms;
+    std::size_t k = std::lower_bound(platform_x.begin(), platform_x.end(), cx - ENV_VIEW - widest_platform) - platform_x.begin();
+    for (; k < platform_x.size() && platform_x[k] < cx + ENV_VIEW; ++k) {
+        if (!in_view(platform_x[k], platform_y[k], platform_width[k], platform_height[k])) continue;
+        platforms.offer(distance_to(cx, cy, platform_x[k], platform_y[k], platform_width[k], platform_height[k]),
+            relative(platform_x[k], platform_y[k], platform_width[k], platform_height[k]));
+    }
+    const TempPlatforms& temp = world.temp_platforms.columns;
+    for (std::size_t j = shard.temp_begin[i]; j < shard.temp_begin[i + 1]; ++j) {
+        const std::size_t t = shard.temp_order[j];
+        if (!in_view(temp.x[t], temp.y[t], TEMP_PLATFORM_WIDTH, TEMP_PLATFORM_HEIGHT)) continue;
+        platforms.offer(distance_to(cx, cy, temp.x[t], temp.y[t], TEMP_PLATFORM_WIDTH, TEMP_PLATFORM_HEIGHT),
+            relative(temp.x[t], temp.y[t], TEMP_PLATFORM_WIDTH, TEMP_PLATFORM_HEIGHT));
+    }
+    out = platforms.write(out);
+
+    Nearest<ENV_OBSTACLES, 3> obstacles;
+    k = std::lower_bound(obstacle_x.begin(), obstacle_x.end(), cx - ENV_VIEW - largest_obstacle) - obstacle_x.begin();
+    for (; k < obstacle_x.size() && obstacle_x[k] < cx + ENV_VIEW; ++k) {
+        if (!in_view(obstacle_x[k], obstacle_y[k], obstacle_size[k], obstacle_size[k])) continue;
+        const std::array<float, 4> seen = relative(obstacle_x[k], obstacle_y[k], obstacle_size[k], obstacle_size[k]);
+        obstacles.offer(distance_to(cx, cy, obstacle_x[k], obstacle_y[k], obstacle_size[k], obstacle_size[k]),
+            { seen[0], seen[1], seen[2] });
+    }
+    obstacles.write(out);
+}
+
+void VecEnv::reset_shard(Shard& shard) {
+    World& world = *shard.world;
+    for (std::size_t i = 0; i < world.players.size(); ++i) {
+        const std::size_t e = shard.begin + i;
+        world.reset_player(i);
+        best_x[e] = world.players.x[i];
+        episode_ticks[e] = 0;
+        rewards[e] = 0;
+        terminated[e] = 0;
+        truncated[e] = 0;
+    }
+    index_temp_platforms(shard);
+    for (std::size_t i = 0; i < world.players.size(); ++i) {
+        observe(shard, i, &observations[(shard.begin + i) * ENV_OBSERVATION_SIZE]);
+    }
+}
+
+void VecEnv::step_shard(Shard& shard, const std::uint8_t* actions) {
+    World& world = *shard.world;
+    const Players& p = world.players;
+    world.step(actions + shard.begin);
+    for (std::size_t i = 0; i < p.size(); ++i) {
+        const std::size_t e = shard.begin + i;
+        // Players::die has already put the dead back at their spawn.
+        const bool died = world.died_in_last_step(i);
+        const double progress = std::max(0.0, p.x[i] - best_x[e]);
+        best_x[e] += progress;
+        rewards[e] = static_cast<float>(progress * config.progress_reward) + (died ? config.death_reward : 0.0f);
+        ++episode_ticks[e];
+        terminated[e] = died;
+        truncated[e] = !died && config.max_episode_ticks && episode_ticks[e] >= config.max_episode_ticks;
+        if (terminated[e] || truncated[e]) {
+            world.reset_player(i);
+            best_x[e] = p.x[i];
+            episode_ticks[e] = 0;
+        }
+    }
+    index_temp_platforms(shard);
+    for (std::size_t i = 0; i < p.size(); ++i) {
+        observe(shard, i, &observations[(shard.begin + i) * ENV_OBSERVATION_SIZE]);
+    }
+}
+
+void VecEnv::reset() {
+    run(nullptr);
+}
+
+void VecEnv::step(const std::uint8_t* actions) {
+    // A null run() means reset.
+    if (!actions) throw std::invalid_argument("VecEnv::step needs one action per environment");
+    run(actions);
+}
+
+void VecEnv::run(const std::uint8_t* actions) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        step_actions = actions;
+        next_shard = 0;
+        working = workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+    work();
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return working == 0; });
+}
+
+void VecEnv::work() {
+    for (std::size_t s = next_shard++; s < shards.size(); s = next_shard++) {
+        if (step_actions) step_shard(shards[s], step_actions);
+        else reset_shard(shards[s]);
+    }
+}
+
+void VecEnv::worker_loop() {
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        work();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--working == 0) finished.notify_one();
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Level.hpp"
+#include "World.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --- Observation layout, floats per environment ---
+// The player: x / level width, y / level height, velocity x / MOVE_SPEED, velocity y /
+// -JUMP_STRENGTH, on ground, jumps left / MAX_JUMPS, jump in progress, and what is left of
+// the AQUA cooldown as a fraction (1 while at the per-player limit).
+// Then the ENV_PLATFORMS nearest platforms, own AQUA platforms included, as x, y, width and
+// height, and the ENV_OBSTACLES nearest obstacles as x, y and size. Positions are relative
+// to the player's top left corner, everything divided by ENV_VIEW. Objects are ordered
+// nearest first; missing ones are all zeros, so a width or size of 0 means none.
+const std::size_t ENV_PLATFORMS = 8;
+const std::size_t ENV_OBSTACLES = 4;
+const std::size_t ENV_PLAYER_FIELDS = 8;
+const std::size_t ENV_OBSERVATION_SIZE = ENV_PLAYER_FIELDS + 4 * ENV_PLATFORMS + 3 * ENV_OBSTACLES;
+// Objects farther than this from the player's centre, sideways or up and down, are not seen.
+const double ENV_VIEW = 600;
+// Most environments sharing one World.
+const std::size_t ENV_SHARD_SIZE = 256;
+
+struct EnvConfig {
+    float progress_reward = 0.01f; // per pixel beyond the farthest x of the episode
+    float death_reward = -1;       // and the episode ends
+    std::uint32_t max_episode_ticks = 60 * TICKS_PER_SECOND; // then it is truncated; 0: never
+};
+
+// --- Vectorized Environment: a batch of independent games stepped together, for training ---
+// Every environment is one player, and its action each step is a Buttons mask. Players never
+// affect each other (an AQUA platform only carries its owner), so up to ENV_SHARD_SIZE
+// environments share one World and move in the same vectorized World::step. Shards are
+// stepped on worker threads that live as long as the VecEnv; the calling thread works too.
+//
+// Observations, rewards and done flags are written in place into arrays that stay where they
+// are for the life of the VecEnv, so callers (see VecEnvApi.h) can read them without copies.
+// An environment whose episode ended is reset in the same step: its reward and flags belong to
+// the old episode, its observation already to the new one.
+class VecEnv {
+    struct Shard {
+        std::unique_ptr<World> world;
+        std::size_t begin = 0; // first environment; the world's player i is begin + i
+        // Own AQUA platforms by player: indices temp_order[temp_begin[i], temp_begin[i + 1]).
+        std::vector<std::uint32_t> temp_begin, temp_order;
+    };
+
+    // The level's platforms and obstacles sorted by x, for finding the ones in view.
+    std::vector<double> platform_x, platform_y, platform_width, platform_height;
+    std::vector<double> obstacle_x, obstacle_y, obstacle_size;
+    double widest_platform = 0, largest_obstacle = 0;
+
+    EnvConfig config;
+    double spawn_x, spawn_y;
+    std::vector<Shard> shards;
+    std::vector<double> best_x;
+    std::vector<std::uint32_t> episode_ticks;
+    std::vector<float> observations, rewards;
+    std::vector<std::uint8_t> terminated, truncated;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    std::uint64_t generation = 0;
+    std::size_t working = 0;
+    bool stopping = false;
+    std::atomic<std::size_t> next_shard{0};
+    const std::uint8_t* step_actions = nullptr; // of the current run; null to reset
+
+    void index_level(const World& world);
+    void observe(const Shard& shard, std::size_t player, float* out) const;
+    void index_temp_platforms(Shard& shard) const;
+    void reset_shard(Shard& shard);
+    void step_shard(Shard& shard, const std::uint8_t* actions);
+    void run(const std::uint8_t* actions);
+    void work();
+    void worker_loop();
+
+public:
+    // Environments on `level` (nullptr: the built-in level), stepped on `threads` threads
+    // (0: all hardware threads).
+    VecEnv(const LevelData* level, std::size_t envs, const EnvConfig& config = EnvConfig(), unsigned threads = 0);
+    ~VecEnv();
+    VecEnv(const VecEnv&) = delete;
+    VecEnv& operator=(const VecEnv&) = delete;
+
+    std::size_t size() const { return best_x.size(); }
+
+    // Starts a new episode in every environment.
+    void reset();
+    // Advances every environment by one tick; actions holds one Buttons mask per environment.
+    void step(const std::uint8_t* actions);
+
+    // size() rows of ENV_OBSERVATION_SIZE.
+    const float* observation_data() const { return observations.data(); }
+    const float* reward_data() const { return rewards.data(); }
+    const std::uint8_t* terminated_data() const { return terminated.data(); } // died
+    const std::uint8_t* truncated_data() const { return truncated.data(); }   // out of ticks
+};
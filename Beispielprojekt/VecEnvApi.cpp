@@ -0,0 +1,91 @@
+#include "VecEnvApi.h"
+#include "VecEnv.hpp"
+// The VecEnv DLL has no Beispielprojekt.cpp to pull Gosu in.
+#include <Gosu/AutoLink.hpp>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+struct vec_env {
+    VecEnv env;
+
+    vec_env(const LevelData* level, std::size_t envs, const EnvConfig& config, unsigned threads)
+        : env(level, envs, config, threads) {
+    }
+};
+
+// No exception may cross into the caller; the message is kept for vec_env_last_error.
+static thread_local std::string last_error;
+
+template<typename F>
+static auto guarded(F&& f, decltype(f()) failed) -> decltype(f()) {
+    try {
+        return f();
+    }
+    catch (const std::exception& e) {
+        last_error = e.what();
+    }
+    catch (...) {
+        last_error = "unknown error";
+    }
+    return failed;
+}
+
+vec_env_config vec_env_default_config(void) {
+    const EnvConfig defaults;
+    return vec_env_config{ defaults.progress_reward, defaults.death_reward, defaults.max_episode_ticks };
+}
+
+vec_env* vec_env_create(const char* level_file, size_t envs, unsigned threads, const vec_env_config* config) {
+    return guarded([&] {
+        EnvConfig env_config;
+        if (config) env_config = EnvConfig{ config->progress_reward, config->death_reward, config->max_episode_ticks };
+        if (!level_file) return new vec_env(nullptr, envs, env_config, threads);
+        const LevelData level = load_level(level_file);
+        return new vec_env(&level, envs, env_config, threads);
+    }, nullptr);
+}
+
+void vec_env_destroy(vec_env* env) {
+    delete env;
+}
+
+const char* vec_env_last_error(void) {
+    return last_error.c_str();
+}
+
+size_t vec_env_count(const vec_env* env) {
+    return env->env.size();
+}
+
+size_t vec_env_observation_size(void) {
+    return ENV_OBSERVATION_SIZE;
+}
+
+int vec_env_reset(vec_env* env) {
+    return guarded([&] { env->env.reset(); return 0; }, -1);
+}
+
+int vec_env_step(vec_env* env, const uint8_t* actions) {
+    return guarded([&] {
+        if (!actions) throw std::invalid_argument("vec_env_step needs one action per environment");
+        env->env.step(actions);
+        return 0;
+    }, -1);
+}
+
+const float* vec_env_observations(const vec_env* env) {
+    return env->env.observation_data();
+}
+
+const float* vec_env_rewards(const vec_env* env) {
+    return env->env.reward_data();
+}
+
+const uint8_t* vec_env_terminated(const vec_env* env) {
+    return env->env.terminated_data();
+}
+
+const uint8_t* vec_env_truncated(const vec_env* env) {
+    return env->env.truncated_data();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// --- Vectorized Environment C ABI: VecEnv for ctypes, cffi and other foreign callers ---
+// Plain C, so any language that can load a shared library can drive the game. The arrays
+// returned below belong to the environment and stay at the same address until
+// vec_env_destroy; vec_env_reset and vec_env_step rewrite them in place, so e.g. numpy can
+// wrap them once without copying. The VecEnv project builds this into a DLL (with
+// VEC_ENV_EXPORTS and without the window); VecEnvDemo is a C caller of it.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(VEC_ENV_EXPORTS)
+#define VEC_ENV_API __declspec(dllexport)
+#else
+#define VEC_ENV_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct vec_env vec_env;
+
+// Same fields and defaults as EnvConfig in VecEnv.hpp.
+typedef struct vec_env_config {
+    float progress_reward;
+    float death_reward;
+    uint32_t max_episode_ticks;
+} vec_env_config;
+
+VEC_ENV_API vec_env_config vec_env_default_config(void);
+
+// `envs` environments on the level file (NULL: the built-in level), stepped on `threads`
+// threads (0: all hardware threads). config may be NULL for the defaults. Already reset.
+// Returns NULL on failure, see vec_env_last_error.
+VEC_ENV_API vec_env* vec_env_create(const char* level_file, size_t envs, unsigned threads, const vec_env_config* config);
+VEC_ENV_API void vec_env_destroy(vec_env* env);
+
+// Why the last failing call on this thread failed.
+VEC_ENV_API const char* vec_env_last_error(void);
+
+VEC_ENV_API size_t vec_env_count(const vec_env* env);
+// Floats per observation row.
+VEC_ENV_API size_t vec_env_observation_size(void);
+
+// Start a new episode everywhere, or advance every environment by one tick with one Buttons
+// mask per environment (1 left, 2 right, 4 up, 8 down). Return 0, or -1 on failure.
+VEC_ENV_API int vec_env_reset(vec_env* env);
+VEC_ENV_API int vec_env_step(vec_env* env, const uint8_t* actions);
+
+// count rows of observation_size floats, count rewards, count 0/1 flags.
+VEC_ENV_API const float* vec_env_observations(const vec_env* env);
+VEC_ENV_API const float* vec_env_rewards(const vec_env* env);
+VEC_ENV_API const uint8_t* vec_env_terminated(const vec_env* env);
+VEC_ENV_API const uint8_t* vec_env_truncated(const vec_env* env);
+
+#ifdef __cplusplus
+}
+#endif
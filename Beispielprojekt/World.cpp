@@ -0,0 +1,362 @@
+#include "World.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+// Up to this many platforms or obstacles, a step checks each against all players at once, which
+// vectorizes; beyond, it looks up the few near each player in the index.
+static const std::size_t LEVEL_SCAN_LIMIT = 64;
+
+std::size_t Players::add(double px, double py) {
+    x.push_back(px);
+    y.push_back(py);
+    velocity_x.push_back(0);
+    velocity_y.push_back(0);
+    spawn_x.push_back(px);
+    spawn_y.push_back(py);
+    jumps_available.push_back(MAX_JUMPS);
+    on_ground.push_back(0);
+    jump_in_progress.push_back(0);
+    down_pressed_last_frame.push_back(0);
+    temp_platform_count.push_back(0);
+    temp_platform_last_placed.push_back(0);
+    return x.size() - 1;
+}
+
+void Players::die(std::size_t i) {
+    x[i] = spawn_x[i];
+    y[i] = spawn_y[i];
+    velocity_x[i] = 0;
+    velocity_y[i] = 0;
+    jumps_available[i] = MAX_JUMPS;
+}
+
+World::World(double width, double height, const TempPlatformRules& rules)
+    : width(width), height(height), temp_platform_rules(rules) {
+    temp_platform_expiry.reset(tick - 1);
+}
+
+std::size_t World::add_player(double px, double py) {
+    std::size_t i = players.add(px, py);
+    temp_platforms.reserve(players.size() * temp_platform_rules.per_player);
+    temp_platform_expiry.reserve(temp_platforms.capacity());
+    expired.reserve(temp_platforms.capacity());
+    return i;
+}
+
+Platform& LevelGeometry::add_platform(double px, double py, double pw, double ph, Gosu::Color color) {
+    platforms.push_back(arena.create<Platform>(px, py, pw, ph, color));
+    indexed = false;
+    return *platforms.back();
+}
+
+Obstacle& LevelGeometry::add_obstacle(double ox, double oy, double size) {
+    obstacles.push_back(arena.create<Obstacle>(ox, oy, size));
+    indexed = false;
+    return *obstacles.back();
+}
+
+void LevelGeometry::clear() {
+    platforms.clear();
+    obstacles.clear();
+    arena.reset();
+    indexed = false;
+}
+
+void LevelGeometry::index() {
+    // Sorted with the order of addition as tie-break, so equal levels give equal indexes.
+    auto index = [](const auto& objects, auto& by_x, std::vector<double>& xs, double& widest) {
+        std::vector<std::size_t> order(objects.size());
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return objects[a]->x < objects[b]->x; });
+        by_x.clear();
+        xs.clear();
+        widest = 0;
+        for (std::size_t k : order) {
+            by_x.push_back(objects[k]);
+            xs.push_back(objects[k]->x);
+            widest = std::max(widest, objects[k]->width);
+        }
+    };
+    index(platforms, platforms_by_x, platform_x, widest_platform);
+    index(obstacles, obstacles_by_x, obstacle_x, widest_obstacle);
+    indexed = true;
+}
+
+void LevelGeometry::swap(LevelGeometry& other) noexcept {
+    arena.swap(other.arena);
+    platforms.swap(other.platforms);
+    obstacles.swap(other.obstacles);
+    platform_x.swap(other.platform_x);
+    obstacle_x.swap(other.obstacle_x);
+    platforms_by_x.swap(other.platforms_by_x);
+    obstacles_by_x.swap(other.obstacles_by_x);
+    std::swap(widest_platform, other.widest_platform);
+    std::swap(widest_obstacle, other.widest_obstacle);
+    std::swap(indexed, other.indexed);
+}
+
+void World::clear_level() {
+    geometry.clear();
+    tiles.reset();
+}
+
+void World::rebuild_temp_platform_expiry() {
+    // The wheel counts tick - 1 as processed; this tick's expiries are still to come.
+    const TempPlatforms& temp = temp_platforms.columns;
+    temp_platform_expiry.reset(tick - 1);
+    for (std::size_t k = 0; k < temp_platforms.size(); ++k) {
+        const bool overdue = tick - temp.created[k] > temp_platform_rules.lifetime;
+        const std::uint32_t due = overdue ? tick : temp.created[k] + temp_platform_rules.lifetime + 1;
+        temp_platform_expiry.schedule(temp_platforms.handle(k).slot, due);
+    }
+}
+
+void World::reset_player(std::size_t i) {
+    players.die(i);
+    players.on_ground[i] = 0;
+    players.jump_in_progress[i] = 0;
+    players.down_pressed_last_frame[i] = 0;
+    players.temp_platform_last_placed[i] = tick;
+
+    // Only this player's platforms leave the wheel, so a reset costs what it removes.
+    TempPlatforms& temp = temp_platforms.columns;
+    for (std::size_t k = temp_platforms.size(); k-- > 0;) {
+        if (temp.owner[k] != i) continue;
+        temp_platform_expiry.cancel(temp_platforms.handle(k).slot);
+        temp_platforms.despawn_at(k);
+    }
+    players.temp_platform_count[i] = 0;
+}
+
+void World::step(const std::uint8_t* buttons) {
+    const std::size_t n = players.size();
+    events.clear();
+    // Cache-line aligned, like vector storage would be for the vectorized loops below.
+    scratch.reset();
+    next_x = scratch.allocate_array<double>(n, 64);
+    next_y = scratch.allocate_array<double>(n, 64);
+    landed = scratch.allocate_array<double>(n, 64);
+    hit = scratch.allocate_array<double>(n, 64);
+
+    update_temp_platforms(buttons);
+    update_players(buttons);
+    check_obstacles();
+    ++tick;
+}
+
+void World::update_temp_platforms(const std::uint8_t* buttons) {
+    PROFILE_ZONE("temp platforms");
+    Players& p = players;
+    TempPlatforms& temp = temp_platforms.columns;
+    for (std::size_t i = 0; i < p.size(); ++i) {
+        bool down = (buttons[i] & BUTTON_DOWN) != 0;
+        if (down && !p.down_pressed_last_frame[i]) {
+            bool on_cooldown = tick - p.temp_platform_last_placed[i] < temp_platform_rules.cooldown;
+            bool at_limit = p.temp_platform_count[i] >= temp_platform_rules.per_player;
+            if (!at_limit && !on_cooldown && !temp_platforms.full()) {
+                const PoolHandle handle = temp_platforms.spawn();
+                std::size_t k = temp_platforms.size() - 1;
+                temp.x[k] = p.x[i] + PLAYER_SIZE / 2 - TEMP_PLATFORM_WIDTH / 2;
+                temp.y[k] = p.y[i] + PLAYER_SIZE + 2;
+                temp.owner[k] = static_cast<std::uint32_t>(i);
+                temp.created[k] = tick;
+                ++p.temp_platform_count[i];
+                p.temp_platform_last_placed[i] = tick;
+                if (record_events) {
+                    events.push_back(WorldEvent{ EVENT_PLATFORM_PLACED, static_cast<std::uint32_t>(i),
+                        p.x[i] + PLAYER_SIZE / 2, temp.y[k] + TEMP_PLATFORM_HEIGHT / 2 });
+                }
+                temp_platform_expiry.schedule(handle.slot, tick + temp_platform_rules.lifetime + 1);
+            }
+        }
+        p.down_pressed_last_frame[i] = down;
+    }
+
+    // Remove temp platforms after their lifetime. The wheel only yields the ones due now,
+    // in an order that depends on its history, so they are removed by index, highest first:
+    // a rolled-back world then ends up with the same pool order as one that never was.
+    if (temp_platform_expiry.current_tick() != tick - 1) rebuild_temp_platform_expiry();
+    expired.clear();
+    temp_platform_expiry.advance(tick, [&](std::uint32_t slot) {
+        expired.push_back(static_cast<std::uint32_t>(temp_platforms.index_of_slot(slot)));
+    });
+    std::sort(expired.begin(), expired.end(), std::greater<std::uint32_t>());
+    for (std::uint32_t k : expired) {
+        if (record_events) {
+            events.push_back(WorldEvent{ EVENT_PLATFORM_EXPIRED, temp.owner[k],
+                temp.x[k] + TEMP_PLATFORM_WIDTH / 2, temp.y[k] + TEMP_PLATFORM_HEIGHT / 2 });
+        }
+        --p.temp_platform_count[temp.owner[k]];
+        temp_platforms.despawn_at(k);
+    }
+}
+
+// Lands every player that falls onto the platform (px, py, pw) during this tick.
+// Branch-free and over double arrays only, so the compiler can vectorize it across players.
+static void land_on_platform(std::size_t n, double px, double py, double pw,
+    const double* __restrict nx, const double* __restrict y,
+    double* __restrict ny, double* __restrict vy, double* __restrict landed) {
+    for (std::size_t i = 0; i < n; ++i) {
+        bool land = (nx[i] + PLAYER_SIZE > px) & (nx[i] < px + pw) &
+            (y[i] + PLAYER_SIZE <= py) & (ny[i] + PLAYER_SIZE >= py) & (vy[i] >= 0);
+        ny[i] = land ? py - PLAYER_SIZE : ny[i];
+        vy[i] = land ? 0.0 : vy[i];
+        landed[i] = land ? 1.0 : landed[i];
+    }
+}
+
+// Lands every player whose feet pass the top edge of a tile surface during this tick.
+// Scalar, but a row costs only a few bit tests, and a tick rarely crosses more than one.
+static void land_on_tiles(const TileMap& tiles, std::size_t n,
+    const double* __restrict nx, const double* __restrict y,
+    double* __restrict ny, double* __restrict vy, double* __restrict landed) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (vy[i] < 0) continue;
+        // Rows whose top edge lies between the feet before and after, and the columns the
+        // player overlaps, both with the same bounds as a platform landing.
+        const int first_row = std::max(0, static_cast<int>(std::ceil((y[i] + PLAYER_SIZE) / TILE_SIZE)));
+        const int last_row = std::min(tiles.rows() - 1, static_cast<int>(std::floor((ny[i] + PLAYER_SIZE) / TILE_SIZE)));
+        const int first_column = static_cast<int>(std::floor(nx[i] / TILE_SIZE));
+        const int last_column = static_cast<int>(std::ceil((nx[i] + PLAYER_SIZE) / TILE_SIZE)) - 1;
+        for (int r = first_row; r <= last_row; ++r) {
+            if (!tiles.surface_in_row(r, first_column, last_column)) continue;
+            ny[i] = static_cast<double>(r) * TILE_SIZE - PLAYER_SIZE;
+            vy[i] = 0;
+            landed[i] = 1;
+            break;
+        }
+    }
+}
+
+// Marks every player touching the obstacle rectangle (ox, oy, ow, oh).
+static void touch_obstacle(std::size_t n, double ox, double oy, double ow, double oh,
+    const double* __restrict x, const double* __restrict y, double* __restrict hit) {
+    for (std::size_t i = 0; i < n; ++i) {
+        bool touch = (x[i] < ox + ow) & (x[i] + PLAYER_SIZE > ox) &
+            (y[i] < oy + oh) & (y[i] + PLAYER_SIZE > oy);
+        hit[i] = touch ? 1.0 : hit[i];
+    }
+}
+
+void World::update_players(const std::uint8_t* buttons) {
+    PROFILE_ZONE("update players");
+    const std::size_t n = players.size();
+    double* x = players.x.data();
+    double* y = players.y.data();
+    double* vx = players.velocity_x.data();
+    double* vy = players.velocity_y.data();
+    std::int32_t* jumps = players.jumps_available.data();
+    std::uint8_t* jip = players.jump_in_progress.data();
+    double* nx = next_x;
+    double* ny = next_y;
+    double* on_platform = landed;
+
+    // Input, double jump and gravity
+    for (std::size_t i = 0; i < n; ++i) {
+        std::uint8_t b = buttons[i];
+        vx[i] = ((b & BUTTON_RIGHT) ? MOVE_SPEED : 0.0) - ((b & BUTTON_LEFT) ? MOVE_SPEED : 0.0);
+
+        bool up = (b & BUTTON_UP) != 0;
+        bool jump = up & (jumps[i] > 0) & !jip[i];
+        vy[i] = (jump ? JUMP_STRENGTH : vy[i]) + GRAVITY;
+        jumps[i] -= jump;
+        jip[i] = up & (jip[i] | jump);
+
+        nx[i] = x[i] + vx[i];
+        ny[i] = y[i] + vy[i];
+        on_platform[i] = 0;
+    }
+
+    // Landing: platforms in the outer loop, players in the inner one. In a large level, only
+    // the platforms under each player. Either way a player ends on the highest platform their
+    // feet passed, whatever the order.
+    if (geometry.platforms.size() <= LEVEL_SCAN_LIMIT) {
+        for (const Platform* plat : geometry.platforms) {
+            land_on_platform(n, plat->x, plat->y, plat->width, nx, y, ny, vy, on_platform);
+        }
+    }
+    else {
+        for (std::size_t i = 0; i < n; ++i) {
+            geometry.for_each_platform_between(nx[i], nx[i] + PLAYER_SIZE, [&](const Platform& plat) {
+                land_on_platform(1, plat.x, plat.y, plat.width, nx + i, y + i, ny + i, vy + i, on_platform + i);
+            });
+        }
+    }
+    if (tiles) land_on_tiles(*tiles, n, nx, y, ny, vy, on_platform);
+
+    // AQUA platforms are checked last, each only for its owner.
+    const TempPlatforms& temp = temp_platforms.columns;
+    for (std::size_t k = 0; k < temp_platforms.size(); ++k) {
+        const std::size_t i = temp.owner[k];
+        bool land = (nx[i] + PLAYER_SIZE > temp.x[k]) & (nx[i] < temp.x[k] + TEMP_PLATFORM_WIDTH) &
+            (y[i] + PLAYER_SIZE <= temp.y[k]) & (ny[i] + PLAYER_SIZE >= temp.y[k]) & (vy[i] >= 0);
+        ny[i] = land ? temp.y[k] - PLAYER_SIZE : ny[i];
+        vy[i] = land ? 0.0 : vy[i];
+        on_platform[i] = land ? 1.0 : on_platform[i];
+    }
+
+    // World borders
+    std::uint8_t* ground = players.on_ground.data();
+    std::uint8_t* was_on_ground = nullptr;
+    if (record_events) {
+        was_on_ground = scratch.allocate_array<std::uint8_t>(n);
+        std::copy(ground, ground + n, was_on_ground);
+    }
+    const double max_x = width - PLAYER_SIZE, max_y = height - PLAYER_SIZE;
+    for (std::size_t i = 0; i < n; ++i) {
+        double cx = nx[i] < 0 ? 0 : nx[i];
+        cx = cx > max_x ? max_x : cx;
+        double cy = ny[i] < 0 ? 0 : ny[i];
+        bool floor = cy > max_y;
+        cy = floor ? max_y : cy;
+        vy[i] = floor ? 0.0 : vy[i];
+
+        x[i] = cx;
+        y[i] = cy;
+        ground[i] = (on_platform[i] != 0) | floor;
+        jumps[i] = ground[i] ? MAX_JUMPS : jumps[i];
+    }
+
+    if (was_on_ground) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!ground[i] || was_on_ground[i]) continue;
+            events.push_back(WorldEvent{ EVENT_LANDING, static_cast<std::uint32_t>(i),
+                x[i] + PLAYER_SIZE / 2, y[i] + PLAYER_SIZE });
+        }
+    }
+}
+
+void World::check_obstacles() {
+    PROFILE_ZONE("obstacles");
+    const std::size_t n = players.size();
+    const double* x = players.x.data();
+    const double* y = players.y.data();
+    double* dead = hit;
+
+    for (std::size_t i = 0; i < n; ++i) dead[i] = 0;
+
+    if (geometry.obstacles.size() <= LEVEL_SCAN_LIMIT) {
+        for (const Obstacle* obstacle : geometry.obstacles) {
+            touch_obstacle(n, obstacle->x, obstacle->y, obstacle->width, obstacle->height, x, y, dead);
+        }
+    }
+    else {
+        for (std::size_t i = 0; i < n; ++i) {
+            geometry.for_each_obstacle_between(x[i], x[i] + PLAYER_SIZE, [&](const Obstacle& obstacle) {
+                touch_obstacle(1, obstacle.x, obstacle.y, obstacle.width, obstacle.height, x + i, y + i, dead + i);
+            });
+        }
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        if (dead[i] == 0) continue;
+        if (record_events) {
+            events.push_back(WorldEvent{ EVENT_DEATH, static_cast<std::uint32_t>(i),
+                x[i] + PLAYER_SIZE / 2, y[i] + PLAYER_SIZE / 2 });
+        }
+        players.die(i);
+    }
+}
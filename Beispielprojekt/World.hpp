@@ -0,0 +1,217 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "Objekte.hpp"
+#include "Pool.hpp"
+#include "TileMap.hpp"
+#include "TimerWheel.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// --- Buttons: one bit per key, so a tick of input for one player is a single byte ---
+enum Buttons : std::uint8_t {
+    BUTTON_LEFT = 1,
+    BUTTON_RIGHT = 2,
+    BUTTON_UP = 4,
+    BUTTON_DOWN = 8
+};
+
+// --- Physics Constants (one tick = one Gosu update, 60 per second) ---
+const int TICKS_PER_SECOND = 60;
+const double PLAYER_SIZE = 50;
+const double GRAVITY = 0.5;
+const double JUMP_STRENGTH = -10.0;
+const double MOVE_SPEED = 3.0;
+const std::int32_t MAX_JUMPS = 2;
+
+// --- Temp (AQUA) Platform ---
+const double TEMP_PLATFORM_WIDTH = 100;
+const double TEMP_PLATFORM_HEIGHT = 15;
+const std::uint32_t TEMP_PLATFORM_LIFETIME = 5 * TICKS_PER_SECOND;
+const std::uint32_t PLATFORM_COOLDOWN = 5 * TICKS_PER_SECOND;
+
+// Fixed for the life of a world. Like the level, they are not part of snapshots or
+// replays, so every world of a session must use the same rules.
+struct TempPlatformRules {
+    std::uint32_t per_player = 1; // standing at the same time
+    std::uint32_t lifetime = TEMP_PLATFORM_LIFETIME;
+    std::uint32_t cooldown = PLATFORM_COOLDOWN; // between two placements
+};
+
+// --- Players: one array per field, so the physics step runs across all players at once ---
+class Players {
+public:
+    std::vector<double> x, y, velocity_x, velocity_y;
+    std::vector<double> spawn_x, spawn_y;
+    std::vector<std::int32_t> jumps_available;
+    std::vector<std::uint8_t> on_ground, jump_in_progress, down_pressed_last_frame;
+
+    // The AQUA platforms themselves live in World::temp_platforms.
+    std::vector<std::uint32_t> temp_platform_count, temp_platform_last_placed;
+
+    std::size_t size() const { return x.size(); }
+
+    // Calls f on every per-player array; World::for_each_field adds the rest of the state.
+    template<typename Self, typename F>
+    static void for_each_field(Self& self, F&& f) {
+        f(self.x); f(self.y); f(self.velocity_x); f(self.velocity_y);
+        f(self.spawn_x); f(self.spawn_y);
+        f(self.jumps_available);
+        f(self.on_ground); f(self.jump_in_progress); f(self.down_pressed_last_frame);
+        f(self.temp_platform_count); f(self.temp_platform_last_placed);
+    }
+
+    // Returns the index of the new player. Use World::add_player for players of a world.
+    std::size_t add(double spawn_x, double spawn_y);
+    void die(std::size_t i);
+};
+
+// --- Temp Platforms: every AQUA platform standing, for a Pool ---
+// Only the owner can stand on a platform.
+struct TempPlatforms {
+    std::vector<double> x, y;
+    std::vector<std::uint32_t> owner, created;
+
+    template<typename Self, typename F>
+    static void for_each_field(Self& self, F&& f) {
+        f(self.x); f(self.y);
+        f(self.owner); f(self.created);
+    }
+};
+
+// --- World Events: what happened during the last step, for effects ---
+enum WorldEventType : std::uint8_t {
+    EVENT_DEATH,            // at the centre of the player, before respawning
+    EVENT_LANDING,          // at the middle of the player's feet
+    EVENT_PLATFORM_PLACED,  // at the middle of the AQUA platform
+    EVENT_PLATFORM_EXPIRED
+};
+
+struct WorldEvent {
+    WorldEventType type;
+    std::uint32_t player;
+    double x, y;
+};
+
+// --- Level Geometry: the platforms and obstacles of a level, also sorted by x ---
+// The index lets a step or a draw look only at the objects near a player or the view. A
+// geometry can be built apart from any world, e.g. on a loading thread, and swapped in whole.
+class LevelGeometry {
+    // Platforms and obstacles live here until clear() frees them all at once.
+    Arena arena;
+    std::vector<double> platform_x, obstacle_x;
+    std::vector<Platform*> platforms_by_x;
+    std::vector<Obstacle*> obstacles_by_x;
+    double widest_platform = 0, widest_obstacle = 0;
+    bool indexed = true;
+
+    template<typename T, typename F>
+    static void for_each_between(const std::vector<double>& xs, const std::vector<T*>& objects,
+        double widest, double left, double right, F& f) {
+        std::size_t k = std::lower_bound(xs.begin(), xs.end(), left - widest) - xs.begin();
+        for (; k < xs.size() && xs[k] < right; ++k) {
+            if (xs[k] + objects[k]->width > left) f(*objects[k]);
+        }
+    }
+
+public:
+    // In the order they were added; only add_platform, add_obstacle and clear change them.
+    std::vector<Platform*> platforms;
+    std::vector<Obstacle*> obstacles;
+
+    LevelGeometry() = default;
+    LevelGeometry(const LevelGeometry&) = delete;
+    LevelGeometry& operator=(const LevelGeometry&) = delete;
+
+    Platform& add_platform(double x, double y, double width, double height,
+        Gosu::Color color = Gosu::Color::GRAY);
+    Obstacle& add_obstacle(double x, double y, double size);
+    // Removes all platforms and obstacles. Their memory is kept for the next level.
+    void clear();
+
+    // Sorts the objects by x. The lookups below do it themselves after a change; calling it
+    // beforehand moves the cost to where the level is built.
+    void index();
+    void swap(LevelGeometry& other) noexcept;
+
+    // Calls f on every platform or obstacle that overlaps the x-range [left, right), in order of x.
+    template<typename F>
+    void for_each_platform_between(double left, double right, F&& f) {
+        if (!indexed) index();
+        for_each_between(platform_x, platforms_by_x, widest_platform, left, right, f);
+    }
+    template<typename F>
+    void for_each_obstacle_between(double left, double right, F&& f) {
+        if (!indexed) index();
+        for_each_between(obstacle_x, obstacles_by_x, widest_obstacle, left, right, f);
+    }
+};
+
+// --- World: level geometry, bounds and all players living in it ---
+class World {
+    // Per-tick scratch arrays for World::step, carved from an arena that is reset every tick.
+    Arena scratch;
+    double* next_x = nullptr;
+    double* next_y = nullptr;
+    double* landed = nullptr;
+    double* hit = nullptr;
+
+    // Expiry of every AQUA platform, by pool slot; rebuilt from the pool when state is loaded.
+    TimerWheel temp_platform_expiry;
+    std::vector<std::uint32_t> expired; // pool indices, scratch for update_temp_platforms
+
+    void update_temp_platforms(const std::uint8_t* buttons);
+    void update_players(const std::uint8_t* buttons);
+    void check_obstacles();
+
+public:
+    double width, height;
+    const TempPlatformRules temp_platform_rules;
+    std::uint32_t tick = 0;
+    LevelGeometry geometry;
+    // Optional grid layer; its tiles carry players like platforms do.
+    std::unique_ptr<TileMap> tiles;
+    Players players;
+    Pool<TempPlatforms> temp_platforms;
+
+    // Off by default: simulations nobody watches (rollback, benchmarks) skip the bookkeeping.
+    bool record_events = false;
+    // What happened during the last step, if record_events was set.
+    std::vector<WorldEvent> events;
+
+    World(double width, double height, const TempPlatformRules& rules = TempPlatformRules());
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Adds a player and room for their AQUA platforms. Returns the index of the new player.
+    std::size_t add_player(double spawn_x, double spawn_y);
+
+    Platform& add_platform(double x, double y, double width, double height,
+        Gosu::Color color = Gosu::Color::GRAY) { return geometry.add_platform(x, y, width, height, color); }
+    Obstacle& add_obstacle(double x, double y, double size) { return geometry.add_obstacle(x, y, size); }
+    // Removes all platforms, obstacles and tiles. Their memory is kept for the next level.
+    void clear_level();
+
+    // Calls f on every array of state that changes while playing; snapshots copy these.
+    template<typename Self, typename F>
+    static void for_each_field(Self& self, F&& f) {
+        Players::for_each_field(self.players, f);
+        Pool<TempPlatforms>::for_each_field(self.temp_platforms, f);
+    }
+
+    // Call after tick or temp_platforms were changed from outside, e.g. by loading a snapshot.
+    void rebuild_temp_platform_expiry();
+
+    // Puts a player back at their spawn, without AQUA platforms and with a full cooldown, as
+    // at the start of a world.
+    void reset_player(std::size_t i);
+    // Whether a player touched an obstacle, and so died, during the last step. Only for
+    // players that were there during it.
+    bool died_in_last_step(std::size_t i) const { return hit != nullptr && hit[i] != 0; }
+
+    // Advances the world by one tick. buttons holds one Buttons mask per player.
+    void step(const std::uint8_t* buttons);
+};